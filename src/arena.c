@@ -0,0 +1,84 @@
+#include "arena.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define ARENA_POISON 0xCD
+
+static _Alignas(ARENA_DEFAULT_ALIGN) uint8_t frame_memory[FRAME_ARENA_THREADS][FRAME_ARENA_SIZE];
+static Arena frame_arenas[FRAME_ARENA_THREADS];
+static atomic_int frame_arena_count;
+static _Thread_local Arena* thread_arena;
+// Threads past FRAME_ARENA_THREADS get an empty arena, every allocation fails and is counted
+static _Thread_local Arena thread_overflow_arena = { .name = "frame (no slot)" };
+
+static const char* frame_arena_names[FRAME_ARENA_THREADS] = {
+    "frame 0", "frame 1", "frame 2", "frame 3",
+};
+
+void arena_init(Arena* arena, void* memory, size_t capacity, const char* name)
+{
+    *arena = (Arena){ .base = memory, .capacity = capacity, .name = name };
+}
+
+void* arena_alloc(Arena* arena, size_t size, size_t align)
+{
+    size_t start = (arena->used + (align - 1)) & ~(align - 1);
+    if (start > arena->capacity || size > arena->capacity - start) {
+        arena->overflows++;
+        bool report = (arena->overflows & (arena->overflows - 1)) == 0;
+#ifdef DEBUG
+        report = true;
+#endif
+        if (report) {
+            fprintf(stderr, "arena: %s overflow %u, %zu bytes requested with %zu of %zu used\n",
+                    arena->name, arena->overflows, size, arena->used, arena->capacity);
+        }
+        return NULL;
+    }
+    arena->used = start + size;
+    if (arena->used > arena->high_water) arena->high_water = arena->used;
+    return arena->base + start;
+}
+
+void arena_reset(Arena* arena)
+{
+#ifdef DEBUG
+    if (arena->base) memset(arena->base, ARENA_POISON, arena->used);
+#endif
+    arena->last_used = arena->used;
+    arena->used = 0;
+}
+
+Arena* frame_arena(void)
+{
+    if (!thread_arena) {
+        int index = atomic_fetch_add(&frame_arena_count, 1);
+        if (index < FRAME_ARENA_THREADS) {
+            thread_arena = &frame_arenas[index];
+            arena_init(thread_arena, frame_memory[index], FRAME_ARENA_SIZE, frame_arena_names[index]);
+            memory_register_static(MEMORY_TAG_FRAME, frame_arena_names[index], frame_memory[index], FRAME_ARENA_SIZE);
+        } else {
+            thread_arena = &thread_overflow_arena;
+        }
+    }
+    return thread_arena;
+}
+
+void frame_arena_reset(void)
+{
+    int count = atomic_load(&frame_arena_count);
+    if (count > FRAME_ARENA_THREADS) count = FRAME_ARENA_THREADS;
+    for (int i = 0; i < count; i++) {
+        arena_reset(&frame_arenas[i]);
+    }
+}
+
+const Arena* frame_arena_thread(int index)
+{
+    int count = atomic_load(&frame_arena_count);
+    if (index < 0 || index >= count || index >= FRAME_ARENA_THREADS) return NULL;
+    return &frame_arenas[index];
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Linear allocators for transient data. An Arena hands out memory by
+  bumping an offset through a fixed block and frees everything at once
+  on reset, so per-tick scratch (query results, sort buffers, pair
+  lists) never touches malloc. A request that does not fit returns NULL
+  and is counted; callers treat that like any full static pool.
+
+  The frame arena is split into one sub-arena per thread, found through
+  a thread-local index, so the main thread and the simulation worker
+  allocate without sharing anything. frame_arena_reset empties all of
+  them at the frame's sync point, the one moment no thread is using
+  its arena; nothing allocated from it may be kept past that.
+
+  Every build tracks use and the high watermark and reports overflows,
+  the 1st, 2nd, 4th, 8th and so on, so a steady overflow stays visible
+  without flooding the log. DEBUG builds report every one and poison
+  memory on reset, so data kept past its frame shows up as garbage
+  instead of stale values.
+ */
+#define FRAME_ARENA_SIZE    (2u << 20)           // Bytes per thread
+#define FRAME_ARENA_THREADS 4                    // Main, simulation and room for workers
+#define ARENA_DEFAULT_ALIGN 16
+
+typedef struct {
+    uint8_t* base;
+    size_t capacity;
+    size_t used;
+    size_t last_used;       // `used` at the last reset, what one frame took
+    size_t high_water;
+    uint32_t overflows;
+    const char* name;
+} Arena;
+
+void arena_init(Arena* arena, void* memory, size_t capacity, const char* name);
+// `align` must be a power of two, NULL when the arena is full
+void* arena_alloc(Arena* arena, size_t size, size_t align);
+void arena_reset(Arena* arena);
+
+#define ARENA_ALLOC(arena, type, count) \
+    ((type*)arena_alloc((arena), sizeof(type) * (size_t)(count), _Alignof(type)))
+
+// The calling thread's sub-arena of the frame arena
+Arena* frame_arena(void);
+// Empties every sub-arena, only while no other thread can allocate
+void frame_arena_reset(void);
+// Sub-arena `index`, NULL past the threads that have used one, for reporting
+const Arena* frame_arena_thread(int index);
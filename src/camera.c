@@ -1,5 +0,0 @@
-#include "camera.h"
-#include "ecs.h"
-
-ECS_COMPONENT_ACCESSORS(camera, CameraComponent, COMPONENT_CAMERA)
-ECS_COMPONENT_ACCESSORS(follow, FollowComponent, COMPONENT_FOLLOW)
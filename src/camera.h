@@ -18,8 +18,5 @@ typedef struct {
     vec3 offset;
 } FollowComponent;
 
-CameraComponent* entity_get_camera(Entity e);
-void entity_set_camera(Entity e, CameraComponent component);
-
-FollowComponent* entity_get_follow(Entity e);
-void entity_set_follow(Entity e, FollowComponent);
+ECS_COMPONENT_DECLARE(camera, CameraComponent, COMPONENT_CAMERA)
+ECS_COMPONENT_DECLARE(follow, FollowComponent, COMPONENT_FOLLOW)
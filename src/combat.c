@@ -0,0 +1,106 @@
+#include "combat.h"
+#include "physics.h"
+#include "flowfield.h"
+#include "profile.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static HitRecord hits[COMBAT_MAX_HITS];
+static uint32_t hit_count;
+
+// Tick serial when each projectile was spent, so it hits at most one target per tick
+static uint32_t spent_serial[MAX_ENTITIES];
+static uint32_t tick_serial;
+
+// Per-target damage totals for this tick and the targets that have one
+static float pending_damage[MAX_ENTITIES];
+static uint32_t damaged_serial[MAX_ENTITIES];
+static Entity damaged[COMBAT_MAX_HITS];
+static uint32_t damaged_count;
+
+static Entity doomed[COMBAT_MAX_HITS * 2];
+
+void combat_init(void)
+{
+    hit_count = 0;
+    damaged_count = 0;
+    memset(spent_serial, 0, sizeof(spent_serial));
+    memset(damaged_serial, 0, sizeof(damaged_serial));
+    tick_serial = 1;
+
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, hits);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, spent_serial);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, pending_damage);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, damaged_serial);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, damaged);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, doomed);
+}
+
+bool combat_record_hit(Entity projectile, Entity target, float damage, const vec3 position)
+{
+    if (combat_projectile_spent(projectile) || hit_count >= COMBAT_MAX_HITS) return false;
+    spent_serial[projectile] = tick_serial;
+    hits[hit_count++] = (HitRecord){
+        .projectile = projectile,
+        .target = target,
+        .damage = damage,
+        .position = { position[0], position[1], position[2] }
+    };
+    return true;
+}
+
+bool combat_projectile_spent(Entity projectile)
+{
+    return projectile < MAX_ENTITIES && spent_serial[projectile] == tick_serial;
+}
+
+void combat_system_update(void)
+{
+    PROFILE_BEGIN("combat_system_update");
+
+    // Aggregate, targets without health just absorb the projectile
+    for (uint32_t i = 0; i < hit_count; i++) {
+        const HitRecord* hit = &hits[i];
+        printf("Projectile %u hit entity %u at position (%f, %f, %f)\n",
+               hit->projectile, hit->target, hit->position[0], hit->position[1], hit->position[2]);
+        if (!entity_is_alive(hit->target) || !(registry.component_masks[hit->target] & COMPONENT_HEALTH)) continue;
+        if (damaged_serial[hit->target] != tick_serial) {
+            damaged_serial[hit->target] = tick_serial;
+            pending_damage[hit->target] = 0.0f;
+            damaged[damaged_count++] = hit->target;
+        }
+        pending_damage[hit->target] += hit->damage;
+    }
+
+    // Apply once per target, then destroy everything that died in one batch
+    uint32_t doomed_count = 0;
+    for (uint32_t i = 0; i < hit_count; i++) {
+        doomed[doomed_count++] = hits[i].projectile;
+    }
+    for (uint32_t i = 0; i < damaged_count; i++) {
+        Entity target = damaged[i];
+        HealthComponent* health = entity_get_health(target);
+        health->current_health -= pending_damage[target];
+        if (health->current_health <= 0.0f) {
+            doomed[doomed_count++] = target;
+        }
+    }
+    for (uint32_t i = 0; i < doomed_count; i++) {
+        Entity e = doomed[i];
+        if (!entity_is_alive(e)) continue;
+        CollisionComponent* c = entity_get_collision(e);
+        if (c && c->is_static) flowfield_mark_obstacles_dirty();
+        entity_destroy(e);
+    }
+
+    hit_count = 0;
+    damaged_count = 0;
+    if (++tick_serial == 0) {
+        memset(spent_serial, 0, sizeof(spent_serial));
+        memset(damaged_serial, 0, sizeof(damaged_serial));
+        tick_serial = 1;
+    }
+    PROFILE_END("combat_system_update");
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ecs.h"
+
+/*
+  Damage is resolved after physics instead of inside the pair loop.
+  Physics records one hit per projectile per tick; combat_system_update
+  sums damage per target, applies it in one pass over HealthComponent,
+  then destroys spent projectiles and dead targets together. Damage
+  modifiers belong in the apply pass, not in the collision loop.
+ */
+#define COMBAT_MAX_HITS 4096
+
+typedef struct {
+    Entity projectile;
+    Entity target;
+    float damage;
+    vec3 position;   // Projectile position at impact
+} HitRecord;
+
+void combat_init(void);
+
+// Returns false if the projectile already hit something this tick, or the buffer is full
+bool combat_record_hit(Entity projectile, Entity target, float damage, const vec3 position);
+bool combat_projectile_spent(Entity projectile);
+
+void combat_system_update(void);
@@ -14,48 +14,47 @@
 #include "camera.h"
 #include "physics.h"
 #include "projectile.h"
+#include "zombie.h"
+#include "arena.h"
+#include "simd_math.h"
+#include "memory.h"
 
 Registry registry = {0};
-static TransformComponent transform_pool[MAX_ENTITIES];
-static RenderComponent render_pool[MAX_ENTITIES];
-static CameraComponent camera_pool[MAX_ENTITIES];
-static FollowComponent follow_pool[MAX_ENTITIES];
-static CollisionComponent collision_pool[MAX_ENTITIES];
-static ProjectileComponent projectile_pool[MAX_ENTITIES];
-static VelocityComponent velocity_pool[MAX_ENTITIES];
-static LifetimeComponent lifetime_pool[MAX_ENTITIES];
-static HealthComponent health_pool[MAX_ENTITIES];
-static DamageComponent damage_pool[MAX_ENTITIES];
-
-// TODO: Move health and damage components to other game logic stuff
-ECS_COMPONENT_ACCESSORS(health, HealthComponent, COMPONENT_HEALTH)
-ECS_COMPONENT_ACCESSORS(damage, DamageComponent, COMPONENT_DAMAGE)
+static Entity first_free; // No free slot below this index, keeps bulk spawning linear
+static uint32_t generations[MAX_ENTITIES]; // Bumped on every create, never reset, tells reused slots apart
+
+#define ECS_COMPONENT_POOL(name, type, id) type name##_pool[MAX_ENTITIES];
+ECS_COMPONENTS(ECS_COMPONENT_POOL)
+#undef ECS_COMPONENT_POOL
 
 void ecs_init()
 {
     memset(&registry, 0, sizeof(Registry));
-    memset(&transform_pool, 0, sizeof(transform_pool));
-    memset(&render_pool, 0, sizeof(render_pool));
-    memset(&camera_pool, 0, sizeof(camera_pool));
-    memset(&follow_pool, 0, sizeof(follow_pool));
-    memset(&collision_pool, 0, sizeof(collision_pool));
-    memset(&projectile_pool, 0, sizeof(projectile_pool));
-    memset(&velocity_pool, 0, sizeof(velocity_pool));
-    memset(&lifetime_pool, 0, sizeof(lifetime_pool));
-    memset(&health_pool, 0, sizeof(health_pool));
-    memset(&damage_pool, 0, sizeof(damage_pool));
+    first_free = 0;
+#define ECS_COMPONENT_CLEAR(name, type, id) memset(name##_pool, 0, sizeof(name##_pool));
+    ECS_COMPONENTS(ECS_COMPONENT_CLEAR)
+#undef ECS_COMPONENT_CLEAR
+
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_ECS, registry);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_ECS, generations);
+#define ECS_COMPONENT_REGISTER(name, type, id) MEMORY_REGISTER_STATIC(MEMORY_TAG_ECS, name##_pool);
+    ECS_COMPONENTS(ECS_COMPONENT_REGISTER)
+#undef ECS_COMPONENT_REGISTER
 }
 
 Entity entity_create()
 {
-    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+    for (Entity e = first_free; e < MAX_ENTITIES; e++) {
         if (!registry.alive[e]) {
             registry.alive[e] = true;
             registry.component_masks[e] = 0;
             registry.entity_count++;
+            generations[e]++;
+            first_free = e + 1;
             return e;
         }
     }
+    first_free = MAX_ENTITIES;
     return INVALID_ENTITY;
 }
 
@@ -77,71 +76,52 @@ void entity_destroy(Entity e)
     registry.alive[e] = false;
     registry.component_masks[e] = 0;
     registry.entity_count--;
+    if (e < first_free) first_free = e;
 }
 
-bool entity_is_alive(Entity e)
+uint32_t entity_generation(Entity e)
 {
-    // 1. Entity index within bounds
-    // 2. Not marked as invalid
-    // 3. Alive flag is true
-    return (e < MAX_ENTITIES) && (e != INVALID_ENTITY) && registry.alive[e];
+    return e < MAX_ENTITIES ? generations[e] : 0;
 }
 
 void* ecs_get_component(Entity e, ComponentType type)
 {
     if (!entity_is_alive(e) || !(registry.component_masks[e] & type)) return NULL;
     switch (type) {
-        case COMPONENT_TRANSFORM: return &transform_pool[e];
-        case COMPONENT_RENDER: return &render_pool[e];
-        case COMPONENT_CAMERA: return &camera_pool[e];
-        case COMPONENT_FOLLOW: return &follow_pool[e];
-        case COMPONENT_COLLISION: return &collision_pool[e];
-        case COMPONENT_PROJECTILE: return &projectile_pool[e];
-        case COMPONENT_VELOCITY: return &velocity_pool[e];
-        case COMPONENT_LIFETIME: return &lifetime_pool[e];
-        case COMPONENT_HEALTH: return &health_pool[e];
-        case COMPONENT_DAMAGE: return &damage_pool[e];
-        // Other cases...
+#define ECS_COMPONENT_CASE(name, type, id) case id: return &name##_pool[e];
+        ECS_COMPONENTS(ECS_COMPONENT_CASE)
+#undef ECS_COMPONENT_CASE
         default: return NULL;
     }
 }
 
+/*
+  Raw access to a whole component pool (MAX_ENTITIES slots), for bulk
+  consumers like state hashing. Slots of dead entities hold stale data.
+ */
+void* ecs_get_pool(ComponentType type, size_t* out_size)
+{
+    void* pool = NULL;
+    size_t size = 0;
+    switch (type) {
+#define ECS_COMPONENT_CASE(name, type, id) case id: pool = name##_pool; size = sizeof(name##_pool); break;
+        ECS_COMPONENTS(ECS_COMPONENT_CASE)
+#undef ECS_COMPONENT_CASE
+        default: break;
+    }
+    if (out_size) *out_size = size;
+    return pool;
+}
+
 void ecs_set_component(Entity e, ComponentType type, void* component)
 {
     if (!entity_is_alive(e)) return;
     registry.component_masks[e] |= type;
     switch (type) {
-        case COMPONENT_TRANSFORM:
-            transform_pool[e] = *(TransformComponent*)component;
-            break;
-        case COMPONENT_RENDER:
-            render_pool[e] = *(RenderComponent*)component;
-            break;
-        case COMPONENT_CAMERA:
-            camera_pool[e] = *(CameraComponent*)component;
-            break;
-        case COMPONENT_FOLLOW:
-            follow_pool[e] = *(FollowComponent*)component;
-            break;
-        case COMPONENT_COLLISION:
-            collision_pool[e] = *(CollisionComponent*)component;
-            break;
-        case COMPONENT_PROJECTILE:
-            projectile_pool[e] = *(ProjectileComponent*)component;
-            break;
-        case COMPONENT_VELOCITY:
-            velocity_pool[e] = *(VelocityComponent*)component;
-            break;
-        case COMPONENT_LIFETIME:
-            lifetime_pool[e] = *(LifetimeComponent*)component;
-            break;
-        case COMPONENT_HEALTH:
-            health_pool[e] = *(HealthComponent*)component;
-            break;
-        case COMPONENT_DAMAGE:
-            damage_pool[e] = *(DamageComponent*)component;
-            break;
-        // Other components...
+#define ECS_COMPONENT_CASE(name, type, id) case id: name##_pool[e] = *(type*)component; break;
+        ECS_COMPONENTS(ECS_COMPONENT_CASE)
+#undef ECS_COMPONENT_CASE
+        default: break;
     }
 }
 
@@ -166,7 +146,20 @@ void follow_system(float delta_time)
                 cosf(pitch_rad) * cosf(yaw_rad)
             };
 
+            // Pull the camera in front of any world geometry between it and the target
             float distance = 5.0f;
+            RaycastHit hit;
+            PhysicsRay ray = {
+                .origin = {target_t->position[0], target_t->position[1], target_t->position[2]},
+                .direction = {-forward[0], -forward[1], -forward[2]},
+                .max_distance = distance,
+                .mask = PHYSICS_LAYER_WORLD,
+                .ignore = follow->target
+            };
+            if (physics_raycast(&ray, &hit)) {
+                distance = fmaxf(hit.distance - 0.2f, 0.5f);
+            }
+
             vec3 offset;
             vec3_scale(offset, forward, -distance);
             vec3_add(cam_t->position, target_t->position, offset);
@@ -174,9 +167,34 @@ void follow_system(float delta_time)
     }
 }
 
-void render_system(int width, int height)
+static bool entity_is_drawn(Entity e)
+{
+    const uint32_t required = COMPONENT_TRANSFORM | COMPONENT_RENDER;
+    return entity_is_alive(e) && (registry.component_masks[e] & required) == required;
+}
+
+static DrawItem draw_item(const RenderComponent* r)
+{
+    return (DrawItem){
+        .pipeline      = r->pipeline,
+        .vertex_buffer = r->vertex_buffer,
+        .index_buffer  = r->index_buffer,
+        .index_count   = r->index_count,
+    };
+}
+
+static void push_draw(const DrawItem* item, mat4x4 const view, const float p[3], float far_plane)
+{
+    // View space looks down -z, the model origin stands in for the mesh
+    float view_z = view[0][2] * p[0] + view[1][2] * p[1] + view[2][2] * p[2] + view[3][2];
+    uint64_t key = render_sort_key(RENDER_PASS_OPAQUE, item->pipeline, 0, item->vertex_buffer, -view_z / far_plane);
+    render_queue_push(key, item);
+}
+
+void render_extract(int width, int height)
 {
     mat4x4 view, proj;
+    float far_plane = 100.0f;
     bool camera_found = false;
 
     for (Entity e = 0; e < MAX_ENTITIES; e++) {
@@ -200,6 +218,7 @@ void render_system(int width, int height)
 
             float fovy_rad = cam->fov * (PI / 180.0f);
             mat4x4_perspective(proj, fovy_rad, cam->aspect, cam->near_plane, cam->far_plane);
+            far_plane = cam->far_plane;
 
             camera_found = true;
             break;
@@ -215,52 +234,49 @@ void render_system(int width, int height)
 
         float fovy_rad = 45.0f * (3.1415926535f / 180.0f);
         float aspect   = (float) width / (float) height;
-        mat4x4_perspective(proj, fovy_rad, aspect, 0.1f, 100.0f);
+        mat4x4_perspective(proj, fovy_rad, aspect, 0.1f, far_plane);
     }
 
-    for (Entity e = 0; e < MAX_ENTITIES; e++) {
-        if (!entity_is_alive(e)) {
-            continue;
+    render_queue_begin();
+
+    mat4x4 view_proj;
+    simd_mat4_mul(view_proj, proj, view);
+
+    // Gathered first so every matrix comes out of one batch call
+    Arena* arena = frame_arena();
+    Entity* drawn = ARENA_ALLOC(arena, Entity, MAX_ENTITIES);
+    TransformComponent* transforms = ARENA_ALLOC(arena, TransformComponent, MAX_ENTITIES);
+    mat4x4* mvps = NULL;
+    uint32_t count = 0;
+    if (drawn && transforms) {
+        for (Entity e = 0; e < MAX_ENTITIES; e++) {
+            if (entity_is_drawn(e)) {
+                drawn[count] = e;
+                transforms[count] = transform_pool[e];
+                count++;
+            }
         }
-        uint32_t mask = registry.component_masks[e];
-        if ((mask & (COMPONENT_TRANSFORM | COMPONENT_RENDER)) ==
-                    (COMPONENT_TRANSFORM | COMPONENT_RENDER))
-        {
-            TransformComponent* t = &transform_pool[e];
-            RenderComponent*    r = &render_pool[e];
-
-            mat4x4 model;
-            mat4x4_identity(model);
-
-            mat4x4_translate_in_place(model,
-                t->position[0],
-                t->position[1],
-                t->position[2]);
-
-            mat4x4 rot;
-            mat4x4_from_quat(rot, t->rotation);
-            mat4x4_mul(model, model, rot);
-
-            mat4x4 scale;
-            mat4x4_identity(scale);
-            scale[0][0] = t->scale[0];
-            scale[1][1] = t->scale[1];
-            scale[2][2] = t->scale[2];
-            mat4x4_mul(model, model, scale);
-
-            mat4x4 mv, mvp;
-            mat4x4_mul(mv, view, model);
-            mat4x4_mul(mvp, proj, mv);
-
-            sg_apply_pipeline(r->pipeline);
-            sg_apply_uniforms(0, &SG_RANGE(mvp));
-            sg_bindings bind = {
-                .vertex_buffers[0] = r->vertex_buffer,
-                .index_buffer      = r->index_buffer
-            };
-            sg_apply_bindings(&bind);
-            sg_draw(0, r->index_count, 1);
+        mvps = ARENA_ALLOC(arena, mat4x4, count);
+    }
+
+    if (mvps) {
+        simd_trs_batch(mvps, view_proj, transforms, count);
+        for (uint32_t i = 0; i < count; i++) {
+            DrawItem item = draw_item(&render_pool[drawn[i]]);
+            memcpy(item.mvp, mvps[i], sizeof(item.mvp));
+            push_draw(&item, view, transforms[i].position, far_plane);
+        }
+    } else {
+        // Frame arena full, the arena reports it: one matrix at a time straight into the item
+        for (Entity e = 0; e < MAX_ENTITIES; e++) {
+            if (!entity_is_drawn(e)) continue;
+            const TransformComponent* t = &transform_pool[e];
+            DrawItem item = draw_item(&render_pool[e]);
+            simd_mat4_trs(item.mvp, t->position, t->rotation, t->scale);
+            simd_mat4_mul(item.mvp, view_proj, item.mvp);
+            push_draw(&item, view, t->position, far_plane);
         }
     }
+    render_queue_end();
 }
 
@@ -13,18 +13,39 @@
 typedef uint32_t Entity;
 #define INVALID_ENTITY MAX_ENTITIES
 
+/*
+  Every component, in mask bit order. This table is the one list the ECS
+  is built from: the ComponentType bits, the pools, ecs_init and the
+  generic get/set/pool lookups are all expanded from it. A component
+  also declares its typed accessors next to its struct with
+  ECS_COMPONENT_DECLARE. New components go at the end, the bits are
+  part of the snapshot and state hash formats.
+ */
+#define ECS_COMPONENTS(X) \
+    X(transform,  TransformComponent,  COMPONENT_TRANSFORM)  \
+    X(render,     RenderComponent,     COMPONENT_RENDER)     \
+    X(camera,     CameraComponent,     COMPONENT_CAMERA)     \
+    X(follow,     FollowComponent,     COMPONENT_FOLLOW)     \
+    X(collision,  CollisionComponent,  COMPONENT_COLLISION)  \
+    X(projectile, ProjectileComponent, COMPONENT_PROJECTILE) \
+    X(velocity,   VelocityComponent,   COMPONENT_VELOCITY)   \
+    X(lifetime,   LifetimeComponent,   COMPONENT_LIFETIME)   \
+    X(health,     HealthComponent,     COMPONENT_HEALTH)     \
+    X(damage,     DamageComponent,     COMPONENT_DAMAGE)     \
+    X(zombie,     ZombieComponent,     COMPONENT_ZOMBIE)
+
+enum {
+#define ECS_COMPONENT_INDEX(name, type, id) id##_INDEX,
+    ECS_COMPONENTS(ECS_COMPONENT_INDEX)
+#undef ECS_COMPONENT_INDEX
+    COMPONENT_COUNT
+};
+
 typedef enum ComponentType {
     COMPONENT_NONE = 0,
-    COMPONENT_TRANSFORM = 1 << 0,
-    COMPONENT_RENDER = 1 << 1,
-    COMPONENT_CAMERA = 1 << 2,
-    COMPONENT_FOLLOW = 1 << 3,
-    COMPONENT_COLLISION = 1 << 4,
-    COMPONENT_PROJECTILE = 1 << 5,
-    COMPONENT_VELOCITY = 1 << 6,
-    COMPONENT_LIFETIME = 1 << 7,
-    COMPONENT_HEALTH = 1 << 8,
-    COMPONENT_DAMAGE = 1 << 9,
+#define ECS_COMPONENT_BIT(name, type, id) id = 1 << id##_INDEX,
+    ECS_COMPONENTS(ECS_COMPONENT_BIT)
+#undef ECS_COMPONENT_BIT
 } ComponentType;
 
 typedef struct {
@@ -44,32 +65,55 @@ typedef struct {
     float damage_amount;
 } DamageComponent;
 
+static inline bool entity_is_alive(Entity e)
+{
+    return e < MAX_ENTITIES && registry.alive[e];
+}
+
 /*
-  Create entity_get_component and entity_set_component
+  Typed accessors that index the pool directly, no switch or void*.
+  entity_get_X checks liveness and the mask and returns NULL otherwise;
+  entity_get_X_unchecked is for loops that already matched the mask;
+  ecs_store_X writes the component and sets its bit. ECS_COMPONENT_DECLARE
+  adds entity_set_X as a plain store, components whose setter does more
+  use ECS_COMPONENT_STORAGE and define entity_set_X themselves.
  */
-#define ECS_COMPONENT_ACCESSORS(name, comp_type, comp_enum) \
-    comp_type* entity_get_##name(Entity e) { \
-        void* ptr = ecs_get_component(e, comp_enum); \
-        return (comp_type*)ptr; \
+#define ECS_COMPONENT_STORAGE(name, type, id) \
+    extern type name##_pool[MAX_ENTITIES]; \
+    static inline type* entity_get_##name(Entity e) { \
+        return entity_is_alive(e) && (registry.component_masks[e] & (id)) ? &name##_pool[e] : NULL; \
+    } \
+    static inline type* entity_get_##name##_unchecked(Entity e) { \
+        return &name##_pool[e]; \
     } \
-    void entity_set_##name(Entity e, comp_type component) { \
-        ecs_set_component(e, comp_enum, &component); \
+    static inline void ecs_store_##name(Entity e, type component) { \
+        if (!entity_is_alive(e)) return; \
+        registry.component_masks[e] |= (id); \
+        name##_pool[e] = component; \
     }
 
+#define ECS_COMPONENT_DECLARE(name, type, id) \
+    ECS_COMPONENT_STORAGE(name, type, id) \
+    static inline void entity_set_##name(Entity e, type component) { \
+        ecs_store_##name(e, component); \
+    }
+
+// TODO: Move health and damage components to other game logic stuff
+ECS_COMPONENT_DECLARE(health, HealthComponent, COMPONENT_HEALTH)
+ECS_COMPONENT_DECLARE(damage, DamageComponent, COMPONENT_DAMAGE)
+
 void ecs_init();
 
 Entity entity_create();
 void entity_destroy(Entity e);
-bool entity_is_alive(Entity e);
+uint32_t entity_generation(Entity e);
 
 void follow_system(float delta_time);
-void render_system(int width, int height);
+// Fills the back render packet from the world, no GPU calls (see render.h)
+void render_extract(int width, int height);
 
+// Generic lookups for code that only has a ComponentType, systems use the typed accessors
 void* ecs_get_component(Entity e, ComponentType type);
+void* ecs_get_pool(ComponentType type, size_t* out_size);
 void ecs_set_component(Entity e, ComponentType type, void* component);
 
-// TODO: Move health and damage components to other game logic stuff
-HealthComponent* entity_get_health(Entity e);
-void entity_set_health(Entity e, HealthComponent component);
-DamageComponent* entity_get_damage(Entity e);
-void entity_set_damage(Entity e, DamageComponent component);
@@ -1,4 +1,6 @@
 #include "event.h"
+#include "profile.h"
+#include "memory.h"
 #include <string.h>
 
 typedef struct {
@@ -8,9 +10,17 @@ typedef struct {
 
 static EventListeners event_listeners[EVENT_COUNT];
 
+// Marker names for the profiler, keep in sync with EventType
+static const char* event_names[EVENT_COUNT] = {
+    [EVENT_SHOOT] = "EVENT_SHOOT",
+    [EVENT_COLLISION_ENTER] = "EVENT_COLLISION_ENTER",
+    [EVENT_COLLISION_EXIT] = "EVENT_COLLISION_EXIT",
+};
+
 void event_init(void)
 {
     memset(event_listeners, 0, sizeof(event_listeners));
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_EVENTS, event_listeners);
 }
 
 void event_register(EventType type, EventListener listener)
@@ -25,10 +35,12 @@ void event_send(EventType type, void* data)
 {
     if (type >= EVENT_COUNT) return;
 
+    PROFILE_BEGIN(event_names[type]);
     EventListeners* listeners = &event_listeners[type];
     for (uint32_t i = 0; i < listeners->listener_count; i++) {
         if (listeners->listeners[i]) {
             listeners->listeners[i](data);
         }
     }
+    PROFILE_END(event_names[type]);
 }
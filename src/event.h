@@ -7,6 +7,8 @@
 
 typedef enum {
     EVENT_SHOOT,
+    EVENT_COLLISION_ENTER,
+    EVENT_COLLISION_EXIT,
     EVENT_COUNT // Must be last
 } EventType;
 
@@ -14,8 +16,20 @@ typedef struct {
     Entity shooter;
     vec3 position;
     vec3 direction;
+    uint32_t command;   // Sequence of the PlayerCommand that fired it, 0 outside networked play
 } ShootEvent;
 
+// Contact pairs are sent once per tick as a batch, a < b
+typedef struct {
+    Entity a;
+    Entity b;
+} CollisionPair;
+
+typedef struct {
+    const CollisionPair* pairs;
+    uint32_t count;
+} CollisionEvent;
+
 typedef void (*EventListener)(void* data);
 
 void event_init(void);
@@ -0,0 +1,175 @@
+#include "flowfield.h"
+#include "ecs.h"
+#include "transform.h"
+#include "physics.h"
+#include "profile.h"
+#include "memory.h"
+
+#include <string.h>
+#include <math.h>
+
+#define FLOWFIELD_CELLS (FLOWFIELD_SIZE * FLOWFIELD_SIZE)
+
+static bool blocked[FLOWFIELD_CELLS];
+static uint16_t distance[FLOWFIELD_CELLS];
+static float direction[FLOWFIELD_CELLS][2];
+static uint32_t queue[FLOWFIELD_CELLS];
+
+static int target_cell = -1;
+static bool obstacles_dirty = true;
+static uint32_t version;
+
+static const int neighbor_dx[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+static const int neighbor_dz[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+static int world_to_cell_coord(float v)
+{
+    return (int)floorf((v - FLOWFIELD_ORIGIN) / FLOWFIELD_CELL_SIZE);
+}
+
+static int world_to_cell(const vec3 position)
+{
+    int x = world_to_cell_coord(position[0]);
+    int z = world_to_cell_coord(position[2]);
+    if (x < 0 || z < 0 || x >= FLOWFIELD_SIZE || z >= FLOWFIELD_SIZE) return -1;
+    return z * FLOWFIELD_SIZE + x;
+}
+
+static int clamp_cell_coord(int v)
+{
+    return v < 0 ? 0 : (v >= FLOWFIELD_SIZE ? FLOWFIELD_SIZE - 1 : v);
+}
+
+void flowfield_init(void)
+{
+    memset(blocked, 0, sizeof(blocked));
+    memset(distance, 0xff, sizeof(distance));
+    memset(direction, 0, sizeof(direction));
+    target_cell = -1;
+    obstacles_dirty = true;
+
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_AI, blocked);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_AI, distance);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_AI, direction);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_AI, queue);
+}
+
+void flowfield_mark_obstacles_dirty(void)
+{
+    obstacles_dirty = true;
+}
+
+static void rasterize_obstacles(void)
+{
+    memset(blocked, 0, sizeof(blocked));
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        if (!entity_is_alive(e)) continue;
+        if (!(registry.component_masks[e] & COMPONENT_COLLISION)) continue;
+        CollisionComponent* c = entity_get_collision(e);
+        if (!c->is_static) continue;
+        if (c->max[1] < FLOWFIELD_AGENT_MIN_Y || c->min[1] > FLOWFIELD_AGENT_MAX_Y) continue;
+
+        int x0 = clamp_cell_coord(world_to_cell_coord(c->min[0]));
+        int x1 = clamp_cell_coord(world_to_cell_coord(c->max[0]));
+        int z0 = clamp_cell_coord(world_to_cell_coord(c->min[2]));
+        int z1 = clamp_cell_coord(world_to_cell_coord(c->max[2]));
+        for (int z = z0; z <= z1; z++) {
+            for (int x = x0; x <= x1; x++) {
+                blocked[z * FLOWFIELD_SIZE + x] = true;
+            }
+        }
+    }
+}
+
+static void integrate(int goal)
+{
+    memset(distance, 0xff, sizeof(distance));
+
+    uint32_t head = 0, tail = 0;
+    distance[goal] = 0;
+    queue[tail++] = (uint32_t)goal;
+
+    // Uniform-cost BFS over the 4-neighborhood
+    while (head < tail) {
+        uint32_t cell = queue[head++];
+        int x = (int)(cell % FLOWFIELD_SIZE);
+        int z = (int)(cell / FLOWFIELD_SIZE);
+        uint16_t next = distance[cell] + 1;
+        for (int n = 0; n < 4; n++) {
+            int nx = x + neighbor_dx[n];
+            int nz = z + neighbor_dz[n];
+            if (nx < 0 || nz < 0 || nx >= FLOWFIELD_SIZE || nz >= FLOWFIELD_SIZE) continue;
+            uint32_t ncell = (uint32_t)(nz * FLOWFIELD_SIZE + nx);
+            if (blocked[ncell] || distance[ncell] != FLOWFIELD_UNREACHABLE) continue;
+            distance[ncell] = next;
+            queue[tail++] = ncell;
+        }
+    }
+
+    // Point each cell at its lowest-distance 8-neighbor, without cutting blocked corners
+    for (int z = 0; z < FLOWFIELD_SIZE; z++) {
+        for (int x = 0; x < FLOWFIELD_SIZE; x++) {
+            int cell = z * FLOWFIELD_SIZE + x;
+            direction[cell][0] = 0.0f;
+            direction[cell][1] = 0.0f;
+            if (distance[cell] == FLOWFIELD_UNREACHABLE || cell == goal) continue;
+
+            uint16_t best = distance[cell];
+            int best_n = -1;
+            for (int n = 0; n < 8; n++) {
+                int nx = x + neighbor_dx[n];
+                int nz = z + neighbor_dz[n];
+                if (nx < 0 || nz < 0 || nx >= FLOWFIELD_SIZE || nz >= FLOWFIELD_SIZE) continue;
+                if (n >= 4 && (blocked[z * FLOWFIELD_SIZE + nx] || blocked[nz * FLOWFIELD_SIZE + x])) continue;
+                uint16_t d = distance[nz * FLOWFIELD_SIZE + nx];
+                if (d < best) {
+                    best = d;
+                    best_n = n;
+                }
+            }
+            if (best_n < 0) continue;
+
+            float inv_len = best_n >= 4 ? 0.70710678f : 1.0f;
+            direction[cell][0] = (float)neighbor_dx[best_n] * inv_len;
+            direction[cell][1] = (float)neighbor_dz[best_n] * inv_len;
+        }
+    }
+}
+
+void flowfield_update(const vec3 target)
+{
+    int cell = world_to_cell(target);
+    if (cell < 0) return;
+    if (cell == target_cell && !obstacles_dirty) return;
+
+    PROFILE_BEGIN("flowfield_update");
+    if (obstacles_dirty) {
+        rasterize_obstacles();
+        obstacles_dirty = false;
+    }
+    target_cell = cell;
+    integrate(cell);
+    version++;
+    PROFILE_END("flowfield_update");
+}
+
+bool flowfield_sample(const vec3 position, vec3 out_dir)
+{
+    out_dir[0] = out_dir[1] = out_dir[2] = 0.0f;
+    int cell = world_to_cell(position);
+    if (cell < 0 || distance[cell] == FLOWFIELD_UNREACHABLE) return false;
+    out_dir[0] = direction[cell][0];
+    out_dir[2] = direction[cell][1];
+    return true;
+}
+
+uint16_t flowfield_distance(const vec3 position)
+{
+    int cell = world_to_cell(position);
+    return cell < 0 ? FLOWFIELD_UNREACHABLE : distance[cell];
+}
+
+uint32_t flowfield_version(void)
+{
+    return version;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../libs/linmath/linmath.h"
+
+/*
+  Grid-based flow field on the XZ plane. One breadth-first integration
+  pass from the target cell gives every cell a direction toward the
+  target, so each agent only samples its own cell.
+ */
+#define FLOWFIELD_SIZE      128     // Cells per side
+#define FLOWFIELD_CELL_SIZE 2.0f    // World units per cell
+#define FLOWFIELD_ORIGIN    (-0.5f * FLOWFIELD_SIZE * FLOWFIELD_CELL_SIZE)
+
+// Static colliders overlapping this height band block a cell
+#define FLOWFIELD_AGENT_MIN_Y -0.5f
+#define FLOWFIELD_AGENT_MAX_Y  2.0f
+
+#define FLOWFIELD_UNREACHABLE UINT16_MAX
+
+void flowfield_init(void);
+
+// Call when static colliders are added or removed
+void flowfield_mark_obstacles_dirty(void);
+
+// Rebuilds the field only when the target changed cells or obstacles changed
+void flowfield_update(const vec3 target);
+
+// Unit XZ direction toward the target, false if the cell can't reach it
+bool flowfield_sample(const vec3 position, vec3 out_dir);
+uint16_t flowfield_distance(const vec3 position);
+
+// Bumped every time the field is rebuilt
+uint32_t flowfield_version(void);
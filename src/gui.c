@@ -1,6 +1,10 @@
 #include <stdio.h>
 #include "gui.h"
 #include "transform.h"
+#include "render.h"
+#include "input.h"
+#include "arena.h"
+#include "memory.h"
 
 #define NUKLEAR_IMPLEMENTATION
 #define NK_INCLUDE_FIXED_TYPES
@@ -19,7 +23,7 @@ void gui_render(Entity player)
 {
     struct nk_context* ctx = snk_new_frame();
     
-    if (nk_begin(ctx, "Player Transform", nk_rect(25, 25, 225, 200),
+    if (nk_begin(ctx, "Player Transform", nk_rect(25, 25, 260, 330),
                  NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_TITLE))
     {
         nk_layout_row_dynamic(ctx, 20, 1);
@@ -43,6 +47,59 @@ void gui_render(Entity player)
         } else {
             nk_label(ctx, "No transform data", NK_TEXT_LEFT);
         }
+
+        const RenderStats* rs = render_stats();
+        char draw_str[64];
+        snprintf(draw_str, sizeof(draw_str), "Draws: %u, dropped: %u", rs->draws, rs->dropped);
+        nk_label(ctx, draw_str, NK_TEXT_LEFT);
+
+        char state_str[64];
+        snprintf(state_str, sizeof(state_str), "Pipelines: %u, bindings: %u",
+                 rs->pipeline_changes, rs->binding_changes);
+        nk_label(ctx, state_str, NK_TEXT_LEFT);
+
+        char input_str[64];
+        snprintf(input_str, sizeof(input_str), "Input events dropped: %u", input_dropped_events());
+        nk_label(ctx, input_str, NK_TEXT_LEFT);
+
+        const Arena* arena;
+        for (int i = 0; (arena = frame_arena_thread(i)) != NULL; i++) {
+            char arena_str[96];
+            snprintf(arena_str, sizeof(arena_str), "Arena %d: %zu/%zu KB, peak %zu%s",
+                     i, arena->last_used / 1024, arena->capacity / 1024, arena->high_water / 1024,
+                     arena->overflows ? ", FULL" : "");
+            nk_label(ctx, arena_str, NK_TEXT_LEFT);
+        }
+    }
+    nk_end(ctx);
+
+    if (nk_begin(ctx, "Memory", nk_rect(295, 25, 300, 470),
+                 NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_TITLE | NK_WINDOW_MINIMIZABLE))
+    {
+        for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+            MemoryStats ms;
+            memory_get_stats((MemoryTag)tag, &ms);
+            size_t total = ms.static_bytes + ms.heap_bytes + ms.gpu_bytes;
+
+            nk_layout_row_dynamic(ctx, 18, 1);
+            char tag_str[96];
+            snprintf(tag_str, sizeof(tag_str), "%s: %zu/%zu KB%s", memory_tag_name((MemoryTag)tag),
+                     total / 1024, ms.budget / 1024, ms.over_budget ? ", OVER" : "");
+            nk_label(ctx, tag_str, NK_TEXT_LEFT);
+
+            if (ms.heap_blocks || ms.gpu_buffers) {
+                char live_str[96];
+                snprintf(live_str, sizeof(live_str), "  heap %zu KB in %u, gpu %zu KB in %u",
+                         ms.heap_bytes / 1024, ms.heap_blocks, ms.gpu_bytes / 1024, ms.gpu_buffers);
+                nk_label(ctx, live_str, NK_TEXT_LEFT);
+            }
+
+            if (ms.budget) {
+                nk_layout_row_dynamic(ctx, 10, 1);
+                nk_size used = total < ms.budget ? total / 1024 : ms.budget / 1024;
+                nk_progress(ctx, &used, ms.budget / 1024, nk_false);
+            }
+        }
     }
     nk_end(ctx);
 }
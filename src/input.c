@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include "input.h"
 #include "ecs.h"
 #include "transform.h"
@@ -5,48 +6,88 @@
 #include "macros.h"
 #include "projectile.h"
 #include "event.h"
+#include "memory.h"
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
+#include <time.h>
+#include <stdatomic.h>
 
 static const float MOVE_SPEED   = 6.0f;
 static const float MOUSE_SENSITIVITY = 0.2f;
 static const float MAX_PITCH    = 89.0f;      // lock pitch to avoid flipping the camera
 
+/*
+  Event ring
+ */
+static InputEvent ring[INPUT_RING_SIZE];
+static _Atomic uint32_t ring_head;      // Next slot the producer writes
+static _Atomic uint32_t ring_tail;      // Next slot the consumer reads
+static _Atomic uint32_t ring_dropped;
+static bool mouse_captured;             // Producer side, capture changes on the event thread
+
 void input_init(InputState* input) {
     memset(input, 0, sizeof(InputState));
     //input->mouse_locked = true;
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_EVENTS, ring);
+}
+
+double input_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void ring_push(InputEvent event)
+{
+    uint32_t head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring_tail, memory_order_acquire);
+    if (head - tail == INPUT_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring_dropped, 1, memory_order_relaxed);
+        return;
+    }
+    ring[head & (INPUT_RING_SIZE - 1)] = event;
+    atomic_store_explicit(&ring_head, head + 1, memory_order_release);
 }
 
-void input_handle_event(InputState* state, const sapp_event* ev) {
+void input_push_event(const sapp_event* ev)
+{
+    InputEvent event = { .time = input_time() };
     switch (ev->type) {
         case SAPP_EVENTTYPE_KEY_DOWN:
             if (ev->key_code < 512) {
-                state->keys[ev->key_code] = true;
                 if (ev->key_code == SAPP_KEYCODE_ESCAPE) {
                     sapp_lock_mouse(false);
-                    state->mouse_captured = false;
+                    mouse_captured = false;
                 }
+                event.type = INPUT_EVENT_KEY_DOWN;
+                event.key_code = (uint16_t)ev->key_code;
+                ring_push(event);
             }
             break;
 
         case SAPP_EVENTTYPE_KEY_UP:
             if (ev->key_code < SAPP_KEYCODE_MENU + 1) {
-                state->keys[ev->key_code] = false;
+                event.type = INPUT_EVENT_KEY_UP;
+                event.key_code = (uint16_t)ev->key_code;
+                ring_push(event);
             }
             break;
 
         case SAPP_EVENTTYPE_MOUSE_DOWN:
-            if (ev->mouse_button == SAPP_MOUSEBUTTON_LEFT && !state->mouse_captured) {
+            if (ev->mouse_button == SAPP_MOUSEBUTTON_LEFT && !mouse_captured) {
                 sapp_lock_mouse(true);
-                state->mouse_captured = true;
+                mouse_captured = true;
             }
             break;
 
         case SAPP_EVENTTYPE_MOUSE_MOVE:
-            if (state->mouse_captured) {
-                state->mouse_dx += ev->mouse_dx;
-                state->mouse_dy += ev->mouse_dy;
+            if (mouse_captured) {
+                event.type = INPUT_EVENT_MOUSE_MOVE;
+                event.dx = ev->mouse_dx;
+                event.dy = ev->mouse_dy;
+                ring_push(event);
             }
             break;
 
@@ -54,6 +95,32 @@ void input_handle_event(InputState* state, const sapp_event* ev) {
     }
 }
 
+uint32_t input_drain(InputState* state, double until)
+{
+    uint32_t tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring_head, memory_order_acquire);
+    uint32_t count = 0;
+    for (; tail != head; tail++, count++) {
+        const InputEvent* event = &ring[tail & (INPUT_RING_SIZE - 1)];
+        if (event->time > until) break;
+        switch (event->type) {
+            case INPUT_EVENT_KEY_DOWN: state->keys[event->key_code] = true; break;
+            case INPUT_EVENT_KEY_UP:   state->keys[event->key_code] = false; break;
+            case INPUT_EVENT_MOUSE_MOVE:
+                state->mouse_dx += event->dx;
+                state->mouse_dy += event->dy;
+                break;
+        }
+    }
+    atomic_store_explicit(&ring_tail, tail, memory_order_release);
+    return count;
+}
+
+uint32_t input_dropped_events(void)
+{
+    return atomic_load_explicit(&ring_dropped, memory_order_relaxed);
+}
+
 /*
   Movement
  */
@@ -86,14 +153,13 @@ void input_get_movement_vector(const InputState* input, float speed, vec3 out_ve
     vec3_scale(out_vec, rotated_dir, speed);
 }
 
-void input_process(InputState* input, Entity player, Entity camera, float delta_time)
+/*
+  Commands
+ */
+void input_build_command(InputState* input, float yaw, float pitch, uint32_t sequence, PlayerCommand* out)
 {
-    TransformComponent* t = entity_get_transform(player);
-    CameraComponent* cam = entity_get_camera(camera);
-    if (!t) return;
-
-    static float player_yaw = 0.0f;
-    static float camera_pitch = 0.0f;
+    float player_yaw = yaw;
+    float camera_pitch = pitch;
 
     // Left = +yaw (CCW), Right = -yaw (CW)
     player_yaw -= input->mouse_dx * MOUSE_SENSITIVITY;
@@ -104,15 +170,34 @@ void input_process(InputState* input, Entity player, Entity camera, float delta_
     if (camera_pitch > MAX_PITCH) camera_pitch = MAX_PITCH;
     if (camera_pitch < -MAX_PITCH) camera_pitch = -MAX_PITCH;
 
-    cam->yaw = player_yaw;
-    cam->pitch = camera_pitch;
+    *out = (PlayerCommand){ .sequence = sequence, .yaw = player_yaw, .pitch = camera_pitch };
+    if (input->keys[SAPP_KEYCODE_W]) out->buttons |= INPUT_BUTTON_FORWARD;
+    if (input->keys[SAPP_KEYCODE_S]) out->buttons |= INPUT_BUTTON_BACK;
+    if (input->keys[SAPP_KEYCODE_A]) out->buttons |= INPUT_BUTTON_LEFT;
+    if (input->keys[SAPP_KEYCODE_D]) out->buttons |= INPUT_BUTTON_RIGHT;
+    if (input->keys[SAPP_KEYCODE_SPACE]) {
+        out->buttons |= INPUT_BUTTON_FIRE;
+        input->keys[SAPP_KEYCODE_SPACE] = false; // Debounce
+    }
+
+    input->mouse_dx = 0.0;
+    input->mouse_dy = 0.0;
+}
+
+void input_apply_command(Entity player, const PlayerCommand* command, float delta_time)
+{
+    TransformComponent* t = entity_get_transform(player);
+    if (!t) return;
 
     // Create player rotation quaternion
-    quat_rotate(t->rotation, DEG2RAD(player_yaw), (vec3){0, 1, 0}); // tilt around Y(aw)
+    quat_rotate(t->rotation, DEG2RAD(command->yaw), (vec3){0, 1, 0}); // tilt around Y(aw)
 
-    // Local-space direction e.g., set base_dir W = (0, 0, 1)
+    // Local-space direction e.g., W = (0, 0, 1)
     vec3 base_dir = {0.0f, 0.0f, 0.0f};
-    input_get_movement_direction(input, base_dir);
+    if (command->buttons & INPUT_BUTTON_FORWARD) base_dir[2] += 1.0f;
+    if (command->buttons & INPUT_BUTTON_BACK) base_dir[2] -= 1.0f;
+    if (command->buttons & INPUT_BUTTON_LEFT) base_dir[0] += 1.0f;
+    if (command->buttons & INPUT_BUTTON_RIGHT) base_dir[0] -= 1.0f;
 
     // Rotate base direction by player's quaternion
     // get world-space direction
@@ -124,27 +209,46 @@ void input_process(InputState* input, Entity player, Entity camera, float delta_
     vec3_scale(move_input, move_dir, MOVE_SPEED * delta_time);
 
     vec3_add(t->position, t->position, move_input);
+}
 
-    if (input->keys[SAPP_KEYCODE_SPACE]) {
-        // Compute forward direction from camera
-        float yaw_rad = DEG2RAD(cam->yaw);
-        float pitch_rad = DEG2RAD(cam->pitch);
-        vec3 forward = {
-            cosf(pitch_rad) * sinf(yaw_rad),
-            sinf(pitch_rad),
-            cosf(pitch_rad) * cosf(yaw_rad)
-        };
-        vec3_norm(forward, forward);
-
-        ShootEvent ev = {
-            .shooter = player,
-            .position = { t->position[0], t->position[1], t->position[2] },
-            .direction = { forward[0], forward[1], forward[2] }
-        };
+bool input_command_shot(Entity player, const PlayerCommand* command, ShootEvent* out)
+{
+    TransformComponent* t = entity_get_transform(player);
+    if (!t || !(command->buttons & INPUT_BUTTON_FIRE)) return false;
+
+    // Compute forward direction from the aim
+    float yaw_rad = DEG2RAD(command->yaw);
+    float pitch_rad = DEG2RAD(command->pitch);
+    vec3 forward = {
+        cosf(pitch_rad) * sinf(yaw_rad),
+        sinf(pitch_rad),
+        cosf(pitch_rad) * cosf(yaw_rad)
+    };
+    vec3_norm(forward, forward);
+
+    *out = (ShootEvent){
+        .shooter = player,
+        .position = { t->position[0], t->position[1], t->position[2] },
+        .direction = { forward[0], forward[1], forward[2] },
+        .command = command->sequence,
+    };
+    return true;
+}
+
+void input_process(InputState* input, Entity player, Entity camera, float delta_time)
+{
+    CameraComponent* cam = entity_get_camera(camera);
+    if (!entity_get_transform(player)) return;
+
+    PlayerCommand command;
+    input_build_command(input, cam->yaw, cam->pitch, 0, &command);
+    cam->yaw = command.yaw;
+    cam->pitch = command.pitch;
+
+    input_apply_command(player, &command, delta_time);
+
+    ShootEvent ev;
+    if (input_command_shot(player, &command, &ev)) {
         event_send(EVENT_SHOOT, &ev);
-        input->keys[SAPP_KEYCODE_SPACE] = false; // Debounce
     }
-
-    input->mouse_dx = 0.0;
-    input->mouse_dy = 0.0;
 }
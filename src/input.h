@@ -1,8 +1,10 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "ecs.h"
+#include "event.h"
 #include "../libs/sokol/sokol_app.h"
 #include "../libs/linmath/linmath.h"
 
@@ -12,14 +14,71 @@ typedef struct InputState {
     float mouse_dy;         // change in mouse Y this frame
     float mouse_x;
     float mouse_y;
-    bool  mouse_captured;      // if we're capturing the mouse (typical FPS lock)
 } InputState;
 
+/*
+  Events travel from the sokol event callback to the simulation through
+  a single-producer single-consumer ring, so the two can run on
+  different threads without a lock. The callback only stamps and queues
+  them (and captures the mouse, which must happen on its thread); the
+  simulation drains them into its own InputState right before a tick,
+  and may stop at a timestamp to split a frame's events across several
+  fixed steps. A full ring drops the newest events.
+ */
+#define INPUT_RING_SIZE 1024   // Power of two
+
+typedef enum {
+    INPUT_EVENT_KEY_DOWN,
+    INPUT_EVENT_KEY_UP,
+    INPUT_EVENT_MOUSE_MOVE,
+} InputEventType;
+
+typedef struct {
+    double time;           // input_time() when the event arrived
+    uint8_t type;          // InputEventType
+    uint16_t key_code;
+    float dx, dy;          // Mouse motion
+} InputEvent;
+
+typedef enum {
+    INPUT_BUTTON_FORWARD = 1 << 0,
+    INPUT_BUTTON_BACK    = 1 << 1,
+    INPUT_BUTTON_LEFT    = 1 << 2,
+    INPUT_BUTTON_RIGHT   = 1 << 3,
+    INPUT_BUTTON_FIRE    = 1 << 4,
+} InputButton;
+
+// One tick of player intent. Applying the same commands to the same start state gives the
+// same player on every machine, which is what the server and client prediction rely on.
+typedef struct {
+    uint32_t sequence;
+    float yaw;            // Degrees, player heading
+    float pitch;          // Degrees, aim
+    uint8_t buttons;      // InputButton bits
+    uint8_t reserved[3];
+} PlayerCommand;
+
 void input_init(InputState* input);
-void input_handle_event(InputState* input, const sapp_event* ev);
 void input_update(InputState* input);
 
+// Monotonic seconds the events are stamped with
+double input_time(void);
+// Producer side, call from the sokol event callback only
+void input_push_event(const sapp_event* ev);
+// Consumer side, applies queued events stamped up to `until` to `input`, returns how many
+uint32_t input_drain(InputState* input, double until);
+// Events lost to a full ring since startup
+uint32_t input_dropped_events(void);
+
 void input_get_movement_direction(const InputState* input, vec3 out_dir);
 void input_get_movement_vector(const InputState* input, float speed, vec3 out_vec, float yaw);
 
+// Turns the keys and mouse motion since the last call into a command, consuming them.
+// The mouse turns the view from `yaw`/`pitch`, the camera's, so a loaded snapshot keeps its view.
+void input_build_command(InputState* input, float yaw, float pitch, uint32_t sequence, PlayerCommand* out);
+// Turns and moves `player` by one command
+void input_apply_command(Entity player, const PlayerCommand* command, float delta_time);
+// Fills in the shot a command fires from `player`, false when it fires none
+bool input_command_shot(Entity player, const PlayerCommand* command, ShootEvent* out);
+
 void input_process(InputState* input, Entity player, Entity camera, float delta_time);
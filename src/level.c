@@ -0,0 +1,349 @@
+#define _POSIX_C_SOURCE 200809L
+#include "level.h"
+#include "transform.h"
+#include "physics.h"
+#include "flowfield.h"
+#include "profile.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef struct {
+    LevelPrefab* prefabs;
+    LevelStatic* statics;
+    LevelSpawn* spawns;
+    uint32_t prefab_count, prefab_capacity;
+    uint32_t static_count, static_capacity;
+    uint32_t spawn_count, spawn_capacity;
+} LevelBuilder;
+
+static const char* spawn_type_names[LEVEL_SPAWN_TYPE_COUNT] = {
+    [LEVEL_SPAWN_PLAYER] = "player",
+    [LEVEL_SPAWN_ZOMBIE] = "zombie",
+};
+
+#define LEVEL_GROW(array, count, capacity) do {                                                      \
+        if ((count) == (capacity)) {                                                                 \
+            (capacity) = (capacity) ? (capacity) * 2 : 64;                                           \
+            void* grown = memory_realloc(MEMORY_TAG_LEVEL, (array), (capacity) * sizeof(*(array)));  \
+            if (!grown) goto fail;                                                                   \
+            (array) = grown;                                                                         \
+        }                                                                                            \
+    } while (0)
+
+static bool parse_floats(char** cursor, float* out, int count)
+{
+    for (int i = 0; i < count; i++) {
+        char* tok = strtok_r(NULL, " \t\r\n", cursor);
+        char* end;
+        if (!tok) return false;
+        out[i] = strtof(tok, &end);
+        if (*end != '\0') return false;
+    }
+    return true;
+}
+
+static int find_prefab(const LevelBuilder* b, const char* name)
+{
+    for (uint32_t i = 0; i < b->prefab_count; i++) {
+        if (strncmp(b->prefabs[i].name, name, LEVEL_NAME_SIZE) == 0) return (int)i;
+    }
+    return -1;
+}
+
+static bool parse_text(const char* path, LevelBuilder* b)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "level: failed to open %s\n", path);
+        return false;
+    }
+
+    char line[512];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char* cursor;
+        char* kind = strtok_r(line, " \t\r\n", &cursor);
+        if (!kind) continue;
+
+        if (strcmp(kind, "prefab") == 0) {
+            LEVEL_GROW(b->prefabs, b->prefab_count, b->prefab_capacity);
+            LevelPrefab* p = &b->prefabs[b->prefab_count];
+            memset(p, 0, sizeof(*p));
+            char* name = strtok_r(NULL, " \t\r\n", &cursor);
+            if (!name || strlen(name) >= LEVEL_NAME_SIZE || find_prefab(b, name) >= 0) goto fail;
+            strcpy(p->name, name);
+            for (char* key; (key = strtok_r(NULL, " \t\r\n", &cursor)); ) {
+                if (strcmp(key, "size") == 0) {
+                    if (!parse_floats(&cursor, p->size, 3)) goto fail;
+                } else if (strcmp(key, "health") == 0) {
+                    if (!parse_floats(&cursor, p->health, 2)) goto fail;
+                } else if (strcmp(key, "dynamic") == 0) {
+                    p->flags |= LEVEL_PREFAB_DYNAMIC;
+                } else {
+                    goto fail;
+                }
+            }
+            b->prefab_count++;
+        } else if (strcmp(kind, "static") == 0) {
+            LEVEL_GROW(b->statics, b->static_count, b->static_capacity);
+            LevelStatic* s = &b->statics[b->static_count];
+            *s = (LevelStatic){ .scale = {1, 1, 1}, .rotation = {0, 0, 0, 1} };
+            char* name = strtok_r(NULL, " \t\r\n", &cursor);
+            int prefab = name ? find_prefab(b, name) : -1;
+            if (prefab < 0) goto fail;
+            s->prefab = (uint32_t)prefab;
+            for (char* key; (key = strtok_r(NULL, " \t\r\n", &cursor)); ) {
+                if (strcmp(key, "pos") == 0) {
+                    if (!parse_floats(&cursor, s->position, 3)) goto fail;
+                } else if (strcmp(key, "scale") == 0) {
+                    if (!parse_floats(&cursor, s->scale, 3)) goto fail;
+                } else if (strcmp(key, "rot") == 0) {
+                    if (!parse_floats(&cursor, s->rotation, 4)) goto fail;
+                } else {
+                    goto fail;
+                }
+            }
+            b->static_count++;
+        } else if (strcmp(kind, "spawn") == 0) {
+            LEVEL_GROW(b->spawns, b->spawn_count, b->spawn_capacity);
+            LevelSpawn* s = &b->spawns[b->spawn_count];
+            char* type = strtok_r(NULL, " \t\r\n", &cursor);
+            s->type = LEVEL_SPAWN_TYPE_COUNT;
+            for (uint32_t t = 0; type && t < LEVEL_SPAWN_TYPE_COUNT; t++) {
+                if (strcmp(type, spawn_type_names[t]) == 0) s->type = t;
+            }
+            if (s->type == LEVEL_SPAWN_TYPE_COUNT || !parse_floats(&cursor, s->position, 3)) goto fail;
+            b->spawn_count++;
+        } else {
+            goto fail;
+        }
+    }
+
+    fclose(f);
+    return true;
+
+fail:
+    fprintf(stderr, "level: %s:%d: invalid record\n", path, line_number);
+    fclose(f);
+    return false;
+}
+
+static void builder_free(LevelBuilder* b)
+{
+    memory_free(b->prefabs);
+    memory_free(b->statics);
+    memory_free(b->spawns);
+    memset(b, 0, sizeof(*b));
+}
+
+static LevelHeader make_header(uint32_t prefab_count, uint32_t static_count, uint32_t spawn_count)
+{
+    LevelHeader h = {
+        .magic = LEVEL_MAGIC,
+        .version = LEVEL_VERSION,
+        .prefab_count = prefab_count,
+        .static_count = static_count,
+        .spawn_count = spawn_count,
+    };
+    h.prefab_offset = sizeof(LevelHeader);
+    h.static_offset = h.prefab_offset + (uint64_t)prefab_count * sizeof(LevelPrefab);
+    h.spawn_offset = h.static_offset + (uint64_t)static_count * sizeof(LevelStatic);
+    return h;
+}
+
+static bool load_text(const char* path, Level* level)
+{
+    LevelBuilder b = {0};
+    if (!parse_text(path, &b)) {
+        builder_free(&b);
+        return false;
+    }
+
+    // Pack into the binary layout so both forms share one representation
+    LevelHeader h = make_header(b.prefab_count, b.static_count, b.spawn_count);
+    size_t size = (size_t)(h.spawn_offset + (uint64_t)b.spawn_count * sizeof(LevelSpawn));
+    uint8_t* storage = memory_alloc(MEMORY_TAG_LEVEL, size);
+    if (!storage) {
+        builder_free(&b);
+        return false;
+    }
+    memcpy(storage, &h, sizeof(h));
+    if (b.prefab_count) memcpy(storage + h.prefab_offset, b.prefabs, b.prefab_count * sizeof(LevelPrefab));
+    if (b.static_count) memcpy(storage + h.static_offset, b.statics, b.static_count * sizeof(LevelStatic));
+    if (b.spawn_count) memcpy(storage + h.spawn_offset, b.spawns, b.spawn_count * sizeof(LevelSpawn));
+    builder_free(&b);
+
+    level->storage = storage;
+    level->prefabs = (const LevelPrefab*)(storage + h.prefab_offset);
+    level->statics = (const LevelStatic*)(storage + h.static_offset);
+    level->spawns = (const LevelSpawn*)(storage + h.spawn_offset);
+    level->prefab_count = h.prefab_count;
+    level->static_count = h.static_count;
+    level->spawn_count = h.spawn_count;
+    return true;
+}
+
+static bool range_ok(uint64_t offset, uint64_t count, size_t element, size_t file_size)
+{
+    return offset <= file_size && count <= (file_size - offset) / element && offset % sizeof(float) == 0;
+}
+
+static bool adopt_binary(const uint8_t* data, size_t size, Level* level)
+{
+    const LevelHeader* h = (const LevelHeader*)data;
+    if (size < sizeof(LevelHeader) || h->version != LEVEL_VERSION ||
+        !range_ok(h->prefab_offset, h->prefab_count, sizeof(LevelPrefab), size) ||
+        !range_ok(h->static_offset, h->static_count, sizeof(LevelStatic), size) ||
+        !range_ok(h->spawn_offset, h->spawn_count, sizeof(LevelSpawn), size)) {
+        return false;
+    }
+
+    const LevelStatic* statics = (const LevelStatic*)(data + h->static_offset);
+    for (uint32_t i = 0; i < h->static_count; i++) {
+        if (statics[i].prefab >= h->prefab_count) return false;
+    }
+
+    level->prefabs = (const LevelPrefab*)(data + h->prefab_offset);
+    level->statics = statics;
+    level->spawns = (const LevelSpawn*)(data + h->spawn_offset);
+    level->prefab_count = h->prefab_count;
+    level->static_count = h->static_count;
+    level->spawn_count = h->spawn_count;
+    return true;
+}
+
+bool level_load(const char* path, Level* level)
+{
+    PROFILE_BEGIN("level_load");
+    memset(level, 0, sizeof(*level));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "level: failed to open %s\n", path);
+        PROFILE_END("level_load");
+        return false;
+    }
+
+    uint32_t magic = 0;
+    struct stat st;
+    bool binary = fstat(fd, &st) == 0 && read(fd, &magic, sizeof(magic)) == sizeof(magic) && magic == LEVEL_MAGIC;
+    bool ok = false;
+    if (binary) {
+        void* mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            level->mapping = mapped;
+            level->mapping_size = (size_t)st.st_size;
+            ok = adopt_binary(mapped, (size_t)st.st_size, level);
+        }
+        if (!ok) fprintf(stderr, "level: %s is not a valid version %d level\n", path, LEVEL_VERSION);
+    }
+    close(fd);
+
+    if (!binary) {
+        ok = load_text(path, level);
+    }
+    if (!ok) {
+        level_free(level);
+    }
+    PROFILE_END("level_load");
+    return ok;
+}
+
+void level_free(Level* level)
+{
+    if (level->mapping) munmap(level->mapping, level->mapping_size);
+    memory_free(level->storage);
+    memset(level, 0, sizeof(*level));
+}
+
+bool level_compile(const char* text_path, const char* binary_path)
+{
+    Level level = {0};
+    if (!load_text(text_path, &level)) return false;
+
+    // The packed text storage already is the binary layout
+    const LevelHeader* h = (const LevelHeader*)level.storage;
+    size_t size = (size_t)(h->spawn_offset + (uint64_t)h->spawn_count * sizeof(LevelSpawn));
+
+    bool ok = false;
+    FILE* f = fopen(binary_path, "wb");
+    if (f) {
+        ok = fwrite(level.storage, 1, size, f) == size;
+        ok = (fclose(f) == 0) && ok;
+    }
+    if (ok) {
+        printf("level: compiled %s -> %s (%u prefabs, %u statics, %u spawns)\n",
+               text_path, binary_path, level.prefab_count, level.static_count, level.spawn_count);
+    } else {
+        fprintf(stderr, "level: failed to write %s\n", binary_path);
+    }
+    level_free(&level);
+    return ok;
+}
+
+uint32_t level_spawn_statics(const Level* level, const RenderComponent* render)
+{
+    PROFILE_BEGIN("level_spawn_statics");
+    uint32_t spawned = 0;
+    for (uint32_t i = 0; i < level->static_count; i++) {
+        const LevelStatic* s = &level->statics[i];
+        const LevelPrefab* p = &level->prefabs[s->prefab];
+
+        Entity e = entity_create();
+        if (e == INVALID_ENTITY) {
+            fprintf(stderr, "level: entity limit reached after %u of %u statics\n", spawned, level->static_count);
+            break;
+        }
+
+        TransformComponent t = {
+            .position = {s->position[0], s->position[1], s->position[2]},
+            .rotation = {s->rotation[0], s->rotation[1], s->rotation[2], s->rotation[3]},
+            .scale = {s->scale[0], s->scale[1], s->scale[2]}
+        };
+        CollisionComponent c = {
+            .size = {p->size[0], p->size[1], p->size[2]},
+            .center_offset = {0, 0, 0},
+            .is_static = !(p->flags & LEVEL_PREFAB_DYNAMIC),
+            .layer = PHYSICS_LAYER_WORLD,
+            .mask = PHYSICS_MASK_WORLD
+        };
+        // World AABBs are built here so static colliders are ready before the first tick
+        physics_update_collision_transform(&t, &c);
+
+        entity_set_transform(e, t);
+        entity_set_collision(e, c);
+        if (render) {
+            entity_set_render(e, *render);
+        }
+        if (p->health[1] > 0.0f) {
+            entity_set_health(e, (HealthComponent){ .current_health = p->health[0], .max_health = p->health[1] });
+        }
+        spawned++;
+    }
+    flowfield_mark_obstacles_dirty();
+    PROFILE_END("level_spawn_statics");
+    return spawned;
+}
+
+bool level_find_spawn(const Level* level, LevelSpawnType type, uint32_t index, float out_position[3])
+{
+    for (uint32_t i = 0; i < level->spawn_count; i++) {
+        if (level->spawns[i].type != type) continue;
+        if (index-- == 0) {
+            memcpy(out_position, level->spawns[i].position, sizeof(float) * 3);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ecs.h"
+#include "render.h"
+
+#define LEVEL_MAGIC     0x4c564c5au // "ZLVL"
+#define LEVEL_VERSION   1
+#define LEVEL_NAME_SIZE 32
+
+/*
+  Levels are authored as text and compiled to a binary form with the same
+  records. Text format, one record per line, '#' starts a comment:
+
+    prefab <name> size <x y z> [health <current> <max>] [dynamic]
+    static <prefab> pos <x y z> [scale <x y z>] [rot <x y z w>]
+    spawn <player|zombie> <x y z>
+
+  The binary form is a LevelHeader followed by the three record arrays at
+  the header's offsets, and is used in place straight from the mapping.
+ */
+typedef enum {
+    LEVEL_SPAWN_PLAYER,
+    LEVEL_SPAWN_ZOMBIE,
+    LEVEL_SPAWN_TYPE_COUNT // Must be last
+} LevelSpawnType;
+
+#define LEVEL_PREFAB_DYNAMIC (1u << 0)
+
+typedef struct {
+    char name[LEVEL_NAME_SIZE];
+    float size[3];         // Collision size before scaling
+    float health[2];       // Current, max. Max of 0 means indestructible
+    uint32_t flags;
+} LevelPrefab;
+
+typedef struct {
+    float position[3];
+    float scale[3];
+    float rotation[4];
+    uint32_t prefab;
+} LevelStatic;
+
+typedef struct {
+    float position[3];
+    uint32_t type;         // LevelSpawnType
+} LevelSpawn;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t prefab_count;
+    uint32_t static_count;
+    uint32_t spawn_count;
+    uint32_t reserved;
+    uint64_t prefab_offset;
+    uint64_t static_offset;
+    uint64_t spawn_offset;
+} LevelHeader;
+
+typedef struct {
+    const LevelPrefab* prefabs;
+    const LevelStatic* statics;
+    const LevelSpawn* spawns;
+    uint32_t prefab_count;
+    uint32_t static_count;
+    uint32_t spawn_count;
+
+    void* mapping;          // Binary levels: the file mapping backing the arrays
+    size_t mapping_size;
+    void* storage;          // Text levels: one heap block backing the arrays
+} Level;
+
+// Loads either form, detected by the magic number
+bool level_load(const char* path, Level* level);
+void level_free(Level* level);
+
+bool level_compile(const char* text_path, const char* binary_path);
+
+// Spawns all static geometry in one pass, returns the number of entities created
+uint32_t level_spawn_statics(const Level* level, const RenderComponent* render);
+bool level_find_spawn(const Level* level, LevelSpawnType type, uint32_t index, float out_position[3]);
@@ -0,0 +1,112 @@
+#include "lod.h"
+#include "transform.h"
+#include "profile.h"
+#include "memory.h"
+
+#include <string.h>
+
+static const uint32_t lod_periods[LOD_LEVEL_COUNT] = {
+    [LOD_NEAR] = 1,
+    [LOD_MID] = 2,
+    [LOD_DISTANT] = 4,
+    [LOD_FAR] = 8,
+};
+
+typedef struct {
+    float accumulated;   // dt since the last update
+    float elapsed;       // dt to apply this tick, valid while due
+    uint8_t level;
+    bool managed;
+    bool due;
+} LodState;
+
+static LodState lod_states[MAX_ENTITIES];
+static uint32_t lod_counts[LOD_LEVEL_COUNT];
+static uint32_t lod_tick;
+static float lod_tick_dt;
+static bool lod_physics = true;
+
+void lod_init(void)
+{
+    memset(lod_states, 0, sizeof(lod_states));
+    memset(lod_counts, 0, sizeof(lod_counts));
+    lod_tick = 0;
+    lod_tick_dt = 0.0f;
+
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_AI, lod_states);
+}
+
+static LodLevel lod_level_for(float dist2)
+{
+    if (dist2 < LOD_MID_DISTANCE * LOD_MID_DISTANCE) return LOD_NEAR;
+    if (dist2 < LOD_DISTANT_DISTANCE * LOD_DISTANT_DISTANCE) return LOD_MID;
+    if (dist2 < LOD_FAR_DISTANCE * LOD_FAR_DISTANCE) return LOD_DISTANT;
+    return LOD_FAR;
+}
+
+void lod_begin_tick(const float viewer[3], float delta_time)
+{
+    PROFILE_BEGIN("lod_begin_tick");
+    lod_tick++;
+    lod_tick_dt = delta_time;
+    memset(lod_counts, 0, sizeof(lod_counts));
+
+    const uint32_t required = COMPONENT_ZOMBIE | COMPONENT_TRANSFORM;
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        LodState* s = &lod_states[e];
+        if (!entity_is_alive(e) || (registry.component_masks[e] & required) != required) {
+            // Slot may be reused, start it fresh
+            s->managed = false;
+            s->accumulated = 0.0f;
+            continue;
+        }
+
+        TransformComponent* t = entity_get_transform_unchecked(e);
+        float dx = t->position[0] - viewer[0];
+        float dy = t->position[1] - viewer[1];
+        float dz = t->position[2] - viewer[2];
+        LodLevel level = lod_level_for(dx * dx + dy * dy + dz * dz);
+
+        s->managed = true;
+        s->level = (uint8_t)level;
+        s->accumulated += delta_time;
+        s->due = (lod_tick + e) % lod_periods[level] == 0;
+        if (s->due) {
+            s->elapsed = s->accumulated;
+            s->accumulated = 0.0f;
+        }
+        lod_counts[level]++;
+    }
+    PROFILE_END("lod_begin_tick");
+}
+
+bool lod_is_managed(Entity e)
+{
+    return e < MAX_ENTITIES && lod_states[e].managed;
+}
+
+bool lod_is_due(Entity e)
+{
+    return e >= MAX_ENTITIES || !lod_states[e].managed || lod_states[e].due;
+}
+
+float lod_elapsed(Entity e)
+{
+    if (e >= MAX_ENTITIES || !lod_states[e].managed) return lod_tick_dt;
+    return lod_states[e].elapsed;
+}
+
+void lod_set_physics_enabled(bool enabled)
+{
+    lod_physics = enabled;
+}
+
+bool lod_physics_enabled(void)
+{
+    return lod_physics;
+}
+
+uint32_t lod_level_count(LodLevel level)
+{
+    return level < LOD_LEVEL_COUNT ? lod_counts[level] : 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ecs.h"
+
+/*
+  Update level-of-detail for zombies. Each tick lod_begin_tick buckets
+  every zombie by distance from the viewer; a level with period N updates
+  an entity on the ticks where (tick + entity) % N == 0, so each level's
+  work is spread round-robin across its N ticks. Skipped ticks accumulate
+  dt, which the next update consumes through lod_elapsed.
+ */
+typedef enum {
+    LOD_NEAR,       // Every tick
+    LOD_MID,        // Every 2 ticks
+    LOD_DISTANT,    // Every 4 ticks
+    LOD_FAR,        // Every 8 ticks
+    LOD_LEVEL_COUNT // Must be last
+} LodLevel;
+
+#define LOD_MID_DISTANCE     25.0f
+#define LOD_DISTANT_DISTANCE 50.0f
+#define LOD_FAR_DISTANCE     80.0f
+
+void lod_init(void);
+void lod_begin_tick(const float viewer[3], float delta_time);
+
+// Entities the scheduler doesn't manage are always due with the tick's dt
+bool lod_is_managed(Entity e);
+bool lod_is_due(Entity e);
+float lod_elapsed(Entity e);
+
+// Whether physics integration of managed entities also follows the schedule
+void lod_set_physics_enabled(bool enabled);
+bool lod_physics_enabled(void);
+
+uint32_t lod_level_count(LodLevel level);
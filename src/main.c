@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <math.h>
 #include <assert.h>
+#include <time.h>
 
 #include "linmath.h"
 
@@ -24,26 +25,70 @@
 #include "physics.h"
 #include "event.h"
 #include "projectile.h"
+#include "profile.h"
+#include "replay.h"
+#include "statehash.h"
+#include "snapshot.h"
+#include "level.h"
+#include "flowfield.h"
+#include "zombie.h"
+#include "steering.h"
+#include "lod.h"
+#include "combat.h"
+#include "net.h"
+#include "prediction.h"
+#include "worker.h"
+#include "arena.h"
+#include "simd_math.h"
+#include "memory.h"
 
-static InputState g_input;
+static InputState g_input;        // Owned by the tick, filled from the input event ring
 static Entity player;
 static Entity camera;
 static Entity cube;
+static RenderComponent cube_rc;
 
 static int frame_count;
 
+#define TRACE_OUTPUT_PATH "trace.json"
+#define QUICKSAVE_PATH    "quicksave.zsnap"
+
 // TODO: render manager
 extern sg_shader cube_shader;
 extern sg_pipeline cube_pipeline;
 
+static const char* record_path;
+static const char* snapshot_path;
+static const char* level_path = "levels/arena.lvl";
+static const char* connect_address;
+static uint32_t server_zombies;
+static double net_seconds;    // Run time of headless server/client modes, 0 for no limit
+static uint32_t command_sequence;
+static double command_time;   // Frame time not yet turned into commands
+
+// Key actions that touch the world wait for the frame's sync point, the tick may be running
+static bool quicksave_requested;
+static bool quickload_requested;
+static bool trace_requested;
+
+// Arguments of the tick the worker runs
+static float tick_delta_time;
+static int tick_width;
+static int tick_height;
+
 void cleanup(void);
 
-void init(void)
+// Systems and shared meshes, everything a world needs before its entities
+static void world_init_systems(void)
 {
-    sg_setup(&(sg_desc){ .environment = sglue_environment(), .logger.func = slog_func });
     ecs_init();
     event_init();
     projectile_init();
+    physics_init();
+    combat_init();
+    flowfield_init();
+    lod_init();
+    steering_init();
     input_init(&g_input);
 
     cube = entity_create();
@@ -67,81 +112,17 @@ void init(void)
         3,2,6,  3,6,7
     };
 
-    RenderComponent cube_rc = create_render_component(
+    cube_rc = create_render_component(
         vertices, sizeof(vertices),
         indices, sizeof(indices) / sizeof(indices[0])
     );
+}
 
-    // Original cube
-    Entity cube_e = entity_create();
-    assert(entity_is_alive(cube_e));
+// Camera that follows `target` from above and behind
+static void spawn_camera(float screen_aspect, Entity target, const vec3 target_position)
+{
     float rot[4] = {0.0f, 0.0f, 0.0f, 1.0f };
     vec3 scale = {1, 1, 1};
-    vec3 pos1 = { 0, 0, 20 };
-    vec3 pos2 = { 0, 0, 0 };
-    TransformComponent t = { .position = {pos1[0], pos1[1], pos1[2]}, .rotation = {rot[0], rot[1], rot[2], rot[3]}, .scale = {scale[0], scale[1], scale[2]} };
-    entity_set_transform(cube_e, t);
-    entity_set_render(cube_e, cube_rc);
-    entity_set_collision(cube_e, (CollisionComponent){.size = {1, 1, 1}, .center_offset = {0, 0, 0}, .is_static = true});
-    HealthComponent h_player = { .current_health = 30.0f, .max_health = 100.0f };
-    entity_set_health(cube_e, h_player);
-
-    // New cube 1: Tall thin pillar
-    Entity cube1 = entity_create();
-    vec3 scale1 = {0.5f, 3.0f, 0.5f};  // Thin and tall
-    vec3 pos_c1 = {50.0f, 0.0f, 30.0f};  // Distance: ~58 units
-    TransformComponent t_c1 = { .position = {pos_c1[0], pos_c1[1], pos_c1[2]}, .rotation = {rot[0], rot[1], rot[2], rot[3]}, .scale = {scale1[0], scale1[1], scale1[2]} };
-    entity_set_transform(cube1, t_c1);
-    entity_set_render(cube1, cube_rc);
-    entity_set_collision(cube1, (CollisionComponent){.size = {1, 1, 1}, .center_offset = {0, 0, 0}, .is_static = true});
-    entity_set_health(cube1, h_player);
-
-    // New cube 2: Wide flat platform
-    Entity cube2 = entity_create();
-    vec3 scale2 = {4.0f, 0.2f, 4.0f};  // Wide and flat
-    vec3 pos_c2 = {-30.0f, -1.0f, -40.0f};  // Distance: ~50 units
-    TransformComponent t_c2 = { .position = {pos_c2[0], pos_c2[1], pos_c2[2]}, .rotation = {rot[0], rot[1], rot[2], rot[3]}, .scale = {scale2[0], scale2[1], scale2[2]} };
-    entity_set_transform(cube2, t_c2);
-    entity_set_render(cube2, cube_rc);
-    entity_set_collision(cube2, (CollisionComponent){.size = {1, 1, 1}, .center_offset = {0, 0, 0}, .is_static = true});
-    entity_set_health(cube2, h_player);
-
-    // New cube 3: Long wall
-    Entity cube3 = entity_create();
-    vec3 scale3 = {6.0f, 2.0f, 0.5f};  // Long and thin
-    vec3 pos_c3 = {20.0f, 0.0f, -60.0f};  // Distance: ~63 units
-    TransformComponent t_c3 = { .position = {pos_c3[0], pos_c3[1], pos_c3[2]}, .rotation = {rot[0], rot[1], rot[2], rot[3]}, .scale = {scale3[0], scale3[1], scale3[2]} };
-    entity_set_transform(cube3, t_c3);
-    entity_set_render(cube3, cube_rc);
-    entity_set_collision(cube3, (CollisionComponent){.size = {1, 1, 1}, .center_offset = {0, 0, 0}, .is_static = true});
-    entity_set_health(cube3, h_player);
-
-    // New cube 4: Medium box
-    Entity cube4 = entity_create();
-    vec3 scale4 = {2.0f, 2.0f, 2.0f};  // Larger cube
-    vec3 pos_c4 = {-80.0f, 0.0f, 20.0f};  // Distance: ~82 units
-    TransformComponent t_c4 = { .position = {pos_c4[0], pos_c4[1], pos_c4[2]}, .rotation = {rot[0], rot[1], rot[2], rot[3]}, .scale = {scale4[0], scale4[1], scale4[2]} };
-    entity_set_transform(cube4, t_c4);
-    entity_set_render(cube4, cube_rc);
-    entity_set_collision(cube4, (CollisionComponent){.size = {1, 1, 1}, .center_offset = {0, 0, 0}, .is_static = true});
-    entity_set_health(cube4, h_player);
-
-    // New cube 5: Small floating block
-    Entity cube5 = entity_create();
-    vec3 scale5 = {0.7f, 0.7f, 0.7f};  // Small cube
-    vec3 pos_c5 = {10.0f, 5.0f, 50.0f};  // Distance: ~51 units
-    TransformComponent t_c5 = { .position = {pos_c5[0], pos_c5[1], pos_c5[2]}, .rotation = {rot[0], rot[1], rot[2], rot[3]}, .scale = {scale5[0], scale5[1], scale5[2]} };
-    entity_set_transform(cube5, t_c5);
-    entity_set_render(cube5, cube_rc);
-    entity_set_collision(cube5, (CollisionComponent){.size = {1, 1, 1}, .center_offset = {0, 0, 0}, .is_static = true});
-    entity_set_health(cube5, h_player);
-
-    // Player entity (cube)
-    player = entity_create();
-    TransformComponent t1 = { .position = {pos2[0], pos2[1], pos2[2]}, .rotation = {rot[0], rot[1], rot[2], rot[3]}, .scale = {scale[0], scale[1], scale[2]} };
-    entity_set_transform(player, t1);
-    entity_set_render(player, cube_rc);
-    entity_set_collision(player, (CollisionComponent){.size = {1, 1, 1}, .center_offset = {0, 0, 0}, .is_static = false});
 
     camera = entity_create();
 
@@ -149,42 +130,245 @@ void init(void)
     float offset_y = 5.0f;
     float offset_z = -5.0f;
 
-    TransformComponent* player_t = entity_get_transform(player);
     vec3 initial_camera_pos = {
-        player_t->position[0] + offset_x,
-        player_t->position[1] + offset_y,
-        player_t->position[2] + offset_z,
+        target_position[0] + offset_x,
+        target_position[1] + offset_y,
+        target_position[2] + offset_z,
     };
 
     TransformComponent t2 = { .position = {initial_camera_pos[0], initial_camera_pos[1], initial_camera_pos[2]}, .rotation = {rot[0], rot[1], rot[2], rot[3]}, .scale = {scale[0], scale[1], scale[2]} };
     entity_set_transform(camera, t2);
-    float screen_aspect = (float)sapp_width() / (float)sapp_height();
-    CameraComponent cam = { .fov = 80.0f, .aspect = screen_aspect, .near_plane = 0.1f, .far_plane = 1000.0f, .pitch = 0.0f, .yaw = -90.0f };
+    CameraComponent cam = { .fov = 80.0f, .aspect = screen_aspect, .near_plane = 0.1f, .far_plane = 1000.0f, .pitch = 0.0f, .yaw = 0.0f };
     entity_set_camera(camera, cam);
 
     // Offset: above and behind
-    FollowComponent fol = { .target = player, .offset = {offset_x, offset_y, offset_z }};
+    FollowComponent fol = { .target = target, .offset = {offset_x, offset_y, offset_z }};
     entity_set_follow(camera, fol);
+}
+
+// Player entity (cube)
+static Entity spawn_player(const vec3 position)
+{
+    Entity e = entity_create();
+    TransformComponent t = { .position = {position[0], position[1], position[2]}, .rotation = {0, 0, 0, 1}, .scale = {1, 1, 1} };
+    entity_set_transform(e, t);
+    entity_set_render(e, cube_rc);
+    entity_set_collision(e, (CollisionComponent){.size = {1, 1, 1}, .center_offset = {0, 0, 0}, .is_static = false,
+                                                .layer = PHYSICS_LAYER_PLAYER, .mask = PHYSICS_MASK_PLAYER});
+    return e;
+}
+
+// Builds the simulation world, shared by the windowed app, headless replays and the server
+static void world_init(float screen_aspect)
+{
+    world_init_systems();
+
+    vec3 pos2 = { 0, 0, 0 };
+
+    Level level;
+    if (level_load(level_path, &level)) {
+        level_spawn_statics(&level, &cube_rc);
+        level_find_spawn(&level, LEVEL_SPAWN_PLAYER, 0, pos2);
+        vec3 zombie_pos;
+        for (uint32_t i = 0; level_find_spawn(&level, LEVEL_SPAWN_ZOMBIE, i, zombie_pos); i++) {
+            zombie_spawn(zombie_pos, &cube_rc);
+        }
+        level_free(&level);
+    }
+
+    player = spawn_player(pos2);
+    spawn_camera(screen_aspect, player, entity_get_transform(player)->position);
+}
+
+// Entity handles live in the world, re-resolve them after a snapshot replaced it
+static void resolve_player_and_camera(void)
+{
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        if (!entity_is_alive(e)) continue;
+        FollowComponent* follow = entity_get_follow(e);
+        if (follow && entity_get_camera(e)) {
+            camera = e;
+            player = follow->target;
+            return;
+        }
+    }
+}
+
+static void load_snapshot(const char* path)
+{
+    if (snapshot_load(path, &cube_rc)) {
+        resolve_player_and_camera();
+    }
+}
+
+void init(void)
+{
+    profile_init();
+    sg_setup(&(sg_desc){
+        .environment = sglue_environment(),
+        .logger.func = slog_func,
+        .allocator = {
+            .alloc_fn = memory_alloc_callback,
+            .free_fn = memory_free_callback,
+            .user_data = (void*)(uintptr_t)MEMORY_TAG_RENDER
+        }
+    });
+    render_queue_init();
+    if (connect_address) {
+        // The server owns the world, start empty and mirror its snapshots
+        world_init_systems();
+        player = INVALID_ENTITY;
+        spawn_camera((float)sapp_width() / (float)sapp_height(), player, (vec3){0, 0, 0});
+        if (!net_client_open(connect_address, entity_get_camera(camera)->far_plane)) exit(1);
+    } else {
+        world_init((float)sapp_width() / (float)sapp_height());
+    }
+    if (snapshot_path) {
+        load_snapshot(snapshot_path);
+    }
 
-    //CameraComponent* cam = entity_get_camera(camera);
+    if (record_path) {
+        replay_record_begin(record_path);
+    }
 
-    snk_setup(&(snk_desc_t){0});
+    snk_setup(&(snk_desc_t){
+        .allocator = {
+            .alloc_fn = memory_alloc_callback,
+            .free_fn = memory_free_callback,
+            .user_data = (void*)(uintptr_t)MEMORY_TAG_GUI
+        }
+    });
     nk_style_hide_cursor(snk_new_frame());
+
+    if (!worker_start("simulation")) {
+        fprintf(stderr, "no simulation thread, ticking on the main thread\n");
+    }
 }
 
 void input(const sapp_event* ev)
 {
     snk_handle_event(ev);
-    input_handle_event(&g_input, ev);
+    input_push_event(ev);
+
+    if (ev->type == SAPP_EVENTTYPE_KEY_DOWN && ev->key_code == SAPP_KEYCODE_F9) {
+        trace_requested = true;
+    }
+    if (ev->type == SAPP_EVENTTYPE_KEY_DOWN && ev->key_code == SAPP_KEYCODE_F5) {
+        quicksave_requested = true;
+    }
+    if (ev->type == SAPP_EVENTTYPE_KEY_DOWN && ev->key_code == SAPP_KEYCODE_F6) {
+        quickload_requested = true;
+    }
 }
 
-void frame(void)
+// One simulation tick, everything here must depend only on the world and g_input
+static void simulate(float delta_time)
 {
-    frame_count++;
-    float delta_time = sapp_frame_duration();
+    PROFILE_BEGIN("input_process");
     input_process(&g_input, player, camera, delta_time);
+    PROFILE_END("input_process");
+
+    TransformComponent* viewer = entity_get_transform(camera);
+    if (viewer) {
+        lod_begin_tick(viewer->position, delta_time);
+    }
+    zombie_system_update(player, delta_time);
+    steering_system_update(delta_time);
     physics_system_update(delta_time);
+    combat_system_update();
+
+    PROFILE_BEGIN("follow_system");
     follow_system(delta_time);
+    PROFILE_END("follow_system");
+
+    statehash_log_tick();
+}
+
+// Commands go out at the server's tick rate however fast frames are, each predicted at once.
+// `now` is the input time the frame ends at, each command takes the events up to its own.
+static void predict_player(float delta_time, double now)
+{
+    const double tick_time = 1.0 / NET_TICK_RATE;
+    command_time += delta_time;
+    while (command_time >= tick_time) {
+        command_time -= tick_time;
+        input_drain(&g_input, now - command_time);
+        if (player == INVALID_ENTITY) continue;
+
+        CameraComponent* cam = entity_get_camera(camera);
+        PlayerCommand command;
+        input_build_command(&g_input, cam->yaw, cam->pitch, ++command_sequence, &command);
+        cam->yaw = command.yaw;
+        cam->pitch = command.pitch;
+        prediction_step(player, &command, (float)tick_time);
+        net_client_send_command(&command);
+    }
+    prediction_update_projectiles(delta_time);
+}
+
+// Everything a frame does to the world, ends with the extract of what to draw.
+// Runs on the worker while the main thread submits the previous frame's packet.
+static void tick(void* unused)
+{
+    (void)unused;
+    PROFILE_BEGIN("tick");
+    float delta_time = tick_delta_time;
+    // Sampled as late as possible, events up to this moment still make it into this tick
+    double now = input_time();
+
+    if (net_client_active()) {
+        net_client_poll(&cube_rc);
+        player = net_client_player();
+        entity_get_follow(camera)->target = player;
+        predict_player(delta_time, now);
+        follow_system(delta_time);
+    } else {
+        input_drain(&g_input, now);
+        replay_record_tick(&g_input, delta_time);
+        simulate(delta_time);
+    }
+
+    PROFILE_BEGIN("render_extract");
+    render_extract(tick_width, tick_height);
+    PROFILE_END("render_extract");
+    PROFILE_END("tick");
+}
+
+void frame(void)
+{
+    PROFILE_BEGIN("frame");
+    frame_count++;
+    float delta_time = sapp_frame_duration();
+
+    // Sync point: the last tick is done and the world belongs to this thread until the next
+    // kick. What is drawn below is the world that tick left, one frame behind the simulation.
+    PROFILE_BEGIN("tick_wait");
+    worker_wait();
+    PROFILE_END("tick_wait");
+    render_queue_swap();
+    frame_arena_reset();
+
+    if (quicksave_requested) {
+        snapshot_save(QUICKSAVE_PATH);
+        quicksave_requested = false;
+    }
+    if (quickload_requested) {
+        load_snapshot(QUICKSAVE_PATH);
+        quickload_requested = false;
+    }
+    if (trace_requested) {
+        profile_export_trace(TRACE_OUTPUT_PATH);
+        trace_requested = false;
+    }
+
+    PROFILE_BEGIN("gui_render");
+    gui_render(player);
+    PROFILE_END("gui_render");
+
+    tick_delta_time = delta_time;
+    tick_width = sapp_width();
+    tick_height = sapp_height();
+    worker_kick(tick, NULL);
 
     sg_begin_pass(&(sg_pass){
         .action = {
@@ -200,24 +384,260 @@ void frame(void)
         .swapchain = sglue_swapchain()
     });
     
-    render_system(sapp_width(), sapp_height());
-    gui_render(player);
+    PROFILE_BEGIN("render_submit");
+    render_queue_submit();
+    PROFILE_END("render_submit");
+
+    PROFILE_BEGIN("gui_submit");
     snk_render(sapp_width(),sapp_height());
+    PROFILE_END("gui_submit");
+
     sg_end_pass();
     sg_commit();
+    PROFILE_END("frame");
+    profile_frame_mark();
 }
 
 void cleanup(void)
 {
+    worker_stop();
+    net_client_close();
+    replay_record_end();
+    statehash_log_end();
+    profile_export_trace(TRACE_OUTPUT_PATH);
+    destroy_render_component(&cube_rc);
+    projectile_shutdown();
+    snk_shutdown();
     sg_destroy_shader(cube_shader);
     sg_destroy_pipeline(cube_pipeline);
     sg_shutdown();
+    memory_report_leaks();
+}
+
+// Feeds a recorded input stream through the simulation without a window or GPU
+static int run_replay(const char* path)
+{
+    if (!replay_open(path)) return 1;
+
+    profile_init();
+    render_set_headless(true);
+    world_init(1280.0f / 960.0f);
+
+    uint64_t ticks = 0;
+    float delta_time = 0.0f;
+    float sim_time = 0.0f;
+    clock_t start = clock();
+    while (replay_next_tick(&g_input, &delta_time)) {
+        simulate(delta_time);
+        frame_arena_reset();
+        sim_time += delta_time;
+        frame_count++;
+        ticks++;
+    }
+    double wall_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+    replay_close();
+    statehash_log_end();
+
+    TransformComponent* t = entity_get_transform(player);
+    printf("replay: %llu/%u ticks, %.2fs simulated in %.3fs (%.1fx real time)\n",
+           (unsigned long long)ticks, replay_tick_count(), sim_time, wall_time,
+           wall_time > 0.0 ? sim_time / wall_time : 0.0);
+    if (t) {
+        printf("replay: final player position %f %f %f, %u entities alive\n",
+               t->position[0], t->position[1], t->position[2], registry.entity_count);
+    }
+    profile_export_trace(TRACE_OUTPUT_PATH);
+    memory_report_leaks();
+    return ticks == replay_tick_count() ? 0 : 1;
+}
+
+// Fills the arena up to `count` zombies for load testing, positions come from a fixed LCG
+static void spawn_extra_zombies(uint32_t count)
+{
+    uint32_t existing = 0;
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        existing += entity_is_alive(e) && (registry.component_masks[e] & COMPONENT_ZOMBIE);
+    }
+    uint32_t seed = 12345u;
+    for (uint32_t i = existing; i < count; i++) {
+        vec3 position = {0, 0, 0};
+        for (int axis = 0; axis < 3; axis += 2) {
+            seed = seed * 1664525u + 1013904223u;
+            position[axis] = ((float)(seed >> 8) / (float)(1u << 24)) * 160.0f - 80.0f;
+        }
+        if (zombie_spawn(position, &cube_rc) == INVALID_ENTITY) break;
+    }
+}
+
+// Every client gets its own player next to the host's, which the zombies keep chasing
+static Entity on_client_join(int client)
+{
+    const TransformComponent* host = entity_get_transform(player);
+    vec3 position = { 3.0f * (float)(client + 1), 0.0f, 0.0f };
+    if (host) vec3_add(position, position, host->position);
+    return spawn_player(position);
+}
+
+static void on_client_leave(int client, Entity client_player)
+{
+    (void)client;
+    if (client_player != INVALID_ENTITY) entity_destroy(client_player);
+}
+
+// Authoritative simulation at NET_TICK_RATE, replicating to every connected client
+static int run_server(uint16_t port)
+{
+    if (!net_server_open(port, on_client_join, on_client_leave)) return 1;
+
+    profile_init();
+    render_set_headless(true);
+    world_init(1280.0f / 960.0f);
+    spawn_extra_zombies(server_zombies);
+    printf("server: listening on port %u, %u entities\n", port, registry.entity_count);
+
+    const double tick_time = 1.0 / NET_TICK_RATE;
+    double start = net_time();
+    double next_tick = start;
+    for (uint32_t tick = 0; net_seconds <= 0.0 || net_time() - start < net_seconds; tick++) {
+        net_server_poll();
+        net_server_apply_commands((float)tick_time);
+        simulate((float)tick_time);
+        net_server_send_snapshots(tick);
+        frame_arena_reset();
+        frame_count++;
+
+        next_tick += tick_time;
+        double wait = next_tick - net_time();
+        if (wait > 0.0) {
+            net_sleep(wait);
+        } else if (wait < -0.25) {
+            next_tick = net_time(); // Fell far behind, don't try to catch up in a burst
+        }
+    }
+    net_server_close();
+    statehash_log_end();
+    profile_export_trace(TRACE_OUTPUT_PATH);
+    memory_report_leaks();
+    return 0;
+}
+
+// Mirrors the server's world without a window, for loopback, bandwidth and latency tests.
+// The player walks in a circle and fires twice a second.
+static int run_client(const char* address)
+{
+    profile_init();
+    render_set_headless(true);
+    world_init_systems();
+    if (!net_client_open(address, NET_MAX_VIEW_DISTANCE)) return 1;
+
+    const double tick_time = 1.0 / NET_TICK_RATE;
+    double start = net_time();
+    double next_tick = start;
+    while (net_seconds <= 0.0 || net_time() - start < net_seconds) {
+        net_client_poll(NULL);
+        if (net_time() < next_tick) {
+            net_sleep(0.001);
+            continue;
+        }
+        next_tick += tick_time;
+
+        Entity local = net_client_player();
+        if (local != INVALID_ENTITY) {
+            command_sequence++;
+            PlayerCommand command = {
+                .sequence = command_sequence,
+                .yaw = fmodf((float)command_sequence * 1.5f, 360.0f),
+                .buttons = INPUT_BUTTON_FORWARD | (command_sequence % 30 == 0 ? INPUT_BUTTON_FIRE : 0),
+            };
+            prediction_step(local, &command, (float)tick_time);
+            net_client_send_command(&command);
+        }
+        prediction_update_projectiles((float)tick_time);
+        frame_arena_reset();
+    }
+    net_client_close();
+
+    const PredictionStats* stats = prediction_stats();
+    printf("prediction: %u commands, %u corrections (max error %.3f, %u commands replayed), "
+           "%u/%u shots confirmed, %u expired\n",
+           command_sequence, stats->corrections, stats->max_error, stats->replayed,
+           stats->projectiles_confirmed, stats->projectiles_predicted, stats->projectiles_expired);
+    memory_report_leaks();
+    return 0;
 }
 
 sapp_desc sokol_main(int argc, char* argv[])
 {
     int WINDOW_WIDTH = 1280, WINDOW_HEIGHT = 960;
-    (void)argc; (void)argv;
+    uint16_t server_port = 0;
+    const char* client_address = NULL;
+    const char* replay_path = NULL;
+    const char* hash_log_path = NULL;
+    const char* compare_paths[2] = { NULL, NULL };
+    const char* compile_paths[2] = { NULL, NULL };
+    uint32_t bench_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            level_path = argv[++i];
+        } else if (strcmp(argv[i], "--compile-level") == 0 && i + 2 < argc) {
+            compile_paths[0] = argv[++i];
+            compile_paths[1] = argv[++i];
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshot_path = argv[++i];
+        } else if (strcmp(argv[i], "--hash-log") == 0 && i + 1 < argc) {
+            hash_log_path = argv[++i];
+        } else if (strcmp(argv[i], "--hash-compare") == 0 && i + 2 < argc) {
+            compare_paths[0] = argv[++i];
+            compare_paths[1] = argv[++i];
+        } else if (strcmp(argv[i], "--bench-math") == 0) {
+            bench_count = (i + 1 < argc && argv[i + 1][0] != '-') ? (uint32_t)atoi(argv[++i]) : 100000;
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--zombies") == 0 && i + 1 < argc) {
+            server_zombies = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--net-seconds") == 0 && i + 1 < argc) {
+            net_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--net-budget") == 0 && i + 1 < argc) {
+            net_server_set_budget((uint32_t)(atof(argv[++i]) * 1024.0));
+        } else if (strcmp(argv[i], "--memory-budget") == 0 && i + 1 < argc) {
+            if (!memory_parse_budget(argv[++i])) {
+                fprintf(stderr, "unknown memory tag in %s, expected tag=MB[:buffers]\n", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--server") == 0) {
+            server_port = (i + 1 < argc && argv[i + 1][0] != '-') ? (uint16_t)atoi(argv[++i]) : NET_DEFAULT_PORT;
+        } else if (strcmp(argv[i], "--client") == 0 && i + 1 < argc) {
+            client_address = argv[++i];
+        } else if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+            connect_address = argv[++i];
+        }
+    }
+
+    // Modes run after parsing so their options can come in any order
+    if (compile_paths[0]) {
+        exit(level_compile(compile_paths[0], compile_paths[1]) ? 0 : 1);
+    }
+    if (compare_paths[0]) {
+        exit(statehash_compare(compare_paths[0], compare_paths[1]));
+    }
+    if (bench_count) {
+        exit(simd_math_benchmark(bench_count));
+    }
+    if (hash_log_path) {
+        statehash_log_begin(hash_log_path);
+    }
+    if (replay_path) {
+        exit(run_replay(replay_path));
+    }
+    if (server_port) {
+        exit(run_server(server_port));
+    }
+    if (client_address) {
+        exit(run_client(client_address));
+    }
+
     return (sapp_desc){
         .init_cb = init,
         .frame_cb = frame,
@@ -0,0 +1,308 @@
+#include "memory.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MEMORY_MB (1024u * 1024u)
+
+// Heap blocks carry their tag and size in front and are linked so the leak report can walk them
+typedef struct MemoryBlock {
+    struct MemoryBlock* prev;
+    struct MemoryBlock* next;
+    size_t size;
+    uint32_t tag;
+    uint32_t magic;
+} MemoryBlock;
+
+#define MEMORY_BLOCK_MAGIC  0x4d454d42u
+#define MEMORY_HEADER_SIZE  32
+#define MEMORY_REPORT_LIST  16      // Entries listed per tag, the rest are only counted
+_Static_assert(sizeof(MemoryBlock) <= MEMORY_HEADER_SIZE, "heap header outgrew its slot");
+
+typedef struct {
+    const void* base;
+    const char* name;
+    size_t bytes;
+    MemoryTag tag;
+} MemoryStatic;
+
+typedef struct {
+    uint32_t id;
+    MemoryTag tag;
+    size_t bytes;
+    const char* label;
+} MemoryBuffer;
+
+static const char* tag_names[MEMORY_TAG_COUNT] = {
+    [MEMORY_TAG_ECS]     = "ecs",
+    [MEMORY_TAG_RENDER]  = "render",
+    [MEMORY_TAG_PHYSICS] = "physics",
+    [MEMORY_TAG_AI]      = "ai",
+    [MEMORY_TAG_NET]     = "net",
+    [MEMORY_TAG_EVENTS]  = "events",
+    [MEMORY_TAG_GUI]     = "gui",
+    [MEMORY_TAG_LEVEL]   = "level",
+    [MEMORY_TAG_FRAME]   = "frame",
+    [MEMORY_TAG_DEBUG]   = "debug",
+};
+
+// About twice what the default level and a 2000 zombie server take, --memory-budget overrides them
+static MemoryStats stats[MEMORY_TAG_COUNT] = {
+    [MEMORY_TAG_ECS]     = { .budget = 2 * MEMORY_MB },
+    [MEMORY_TAG_RENDER]  = { .budget = 2 * MEMORY_MB, .buffer_budget = 64 },
+    [MEMORY_TAG_PHYSICS] = { .budget = 4 * MEMORY_MB },
+    [MEMORY_TAG_AI]      = { .budget = 1 * MEMORY_MB },
+    [MEMORY_TAG_NET]     = { .budget = 16 * MEMORY_MB },
+    [MEMORY_TAG_EVENTS]  = { .budget = MEMORY_MB / 8 },
+    [MEMORY_TAG_GUI]     = { .budget = 4 * MEMORY_MB },
+    [MEMORY_TAG_LEVEL]   = { .budget = 4 * MEMORY_MB },
+    [MEMORY_TAG_FRAME]   = { .budget = 8 * MEMORY_MB },
+    [MEMORY_TAG_DEBUG]   = { .budget = 8 * MEMORY_MB },
+};
+
+static pthread_mutex_t memory_lock = PTHREAD_MUTEX_INITIALIZER;
+static MemoryStatic statics[MEMORY_MAX_STATICS];
+static uint32_t static_count;
+static MemoryBuffer buffers[MEMORY_MAX_BUFFERS];
+static uint32_t buffer_count;
+static MemoryBlock* blocks;
+
+const char* memory_tag_name(MemoryTag tag)
+{
+    return tag < MEMORY_TAG_COUNT ? tag_names[tag] : "?";
+}
+
+static size_t tag_total(const MemoryStats* s)
+{
+    return s->static_bytes + s->heap_bytes + s->gpu_bytes;
+}
+
+// Called with the lock held after every change to `tag`
+static void check_budget(MemoryTag tag)
+{
+    MemoryStats* s = &stats[tag];
+    bool over = (s->budget && tag_total(s) > s->budget) ||
+                (s->buffer_budget && s->gpu_buffers > s->buffer_budget);
+    if (over && !s->over_budget) {
+        fprintf(stderr, "memory: %s over budget, %.2f of %.2f MB (static %.2f, heap %.2f, gpu %.2f in %u of %u buffers)\n",
+                tag_names[tag], (double)tag_total(s) / MEMORY_MB, (double)s->budget / MEMORY_MB,
+                (double)s->static_bytes / MEMORY_MB, (double)s->heap_bytes / MEMORY_MB,
+                (double)s->gpu_bytes / MEMORY_MB, s->gpu_buffers, s->buffer_budget);
+    }
+    s->over_budget = over;
+}
+
+void memory_register_static(MemoryTag tag, const char* name, const void* base, size_t bytes)
+{
+    if (tag >= MEMORY_TAG_COUNT) return;
+    pthread_mutex_lock(&memory_lock);
+    bool known = false;
+    for (uint32_t i = 0; i < static_count && !known; i++) {
+        known = statics[i].base == base;
+    }
+    if (!known) {
+        if (static_count < MEMORY_MAX_STATICS) {
+            statics[static_count++] = (MemoryStatic){ .base = base, .name = name, .bytes = bytes, .tag = tag };
+            stats[tag].static_bytes += bytes;
+            check_budget(tag);
+        } else {
+            fprintf(stderr, "memory: static table full, %s not counted\n", name);
+        }
+    }
+    pthread_mutex_unlock(&memory_lock);
+}
+
+static void link_block(MemoryBlock* block)
+{
+    block->prev = NULL;
+    block->next = blocks;
+    if (blocks) blocks->prev = block;
+    blocks = block;
+
+    MemoryStats* s = &stats[block->tag];
+    s->heap_bytes += block->size;
+    s->heap_blocks++;
+    if (s->heap_bytes > s->heap_peak) s->heap_peak = s->heap_bytes;
+    check_budget(block->tag);
+}
+
+static void unlink_block(MemoryBlock* block)
+{
+    if (block->prev) block->prev->next = block->next;
+    else blocks = block->next;
+    if (block->next) block->next->prev = block->prev;
+
+    MemoryStats* s = &stats[block->tag];
+    s->heap_bytes -= block->size;
+    s->heap_blocks--;
+    check_budget(block->tag);
+}
+
+static MemoryBlock* block_of(void* ptr)
+{
+    MemoryBlock* block = (MemoryBlock*)((uint8_t*)ptr - MEMORY_HEADER_SIZE);
+    if (block->magic != MEMORY_BLOCK_MAGIC) {
+        fprintf(stderr, "memory: %p was not allocated by memory_alloc\n", ptr);
+        abort();
+    }
+    return block;
+}
+
+void* memory_alloc(MemoryTag tag, size_t size)
+{
+    if (tag >= MEMORY_TAG_COUNT || size > SIZE_MAX - MEMORY_HEADER_SIZE) return NULL;
+    MemoryBlock* block = malloc(MEMORY_HEADER_SIZE + size);
+    if (!block) return NULL;
+    block->size = size;
+    block->tag = tag;
+    block->magic = MEMORY_BLOCK_MAGIC;
+
+    pthread_mutex_lock(&memory_lock);
+    link_block(block);
+    pthread_mutex_unlock(&memory_lock);
+    return (uint8_t*)block + MEMORY_HEADER_SIZE;
+}
+
+void* memory_realloc(MemoryTag tag, void* ptr, size_t size)
+{
+    if (!ptr) return memory_alloc(tag, size);
+    if (size > SIZE_MAX - MEMORY_HEADER_SIZE) return NULL;
+
+    MemoryBlock* block = block_of(ptr);
+    pthread_mutex_lock(&memory_lock);
+    unlink_block(block);
+    MemoryBlock* grown = realloc(block, MEMORY_HEADER_SIZE + size);
+    if (grown) {
+        grown->size = size;
+        block = grown;
+    }
+    // A failed realloc leaves the old block valid, it goes back on the list unchanged
+    link_block(block);
+    pthread_mutex_unlock(&memory_lock);
+    return grown ? (uint8_t*)grown + MEMORY_HEADER_SIZE : NULL;
+}
+
+void memory_free(void* ptr)
+{
+    if (!ptr) return;
+    MemoryBlock* block = block_of(ptr);
+    pthread_mutex_lock(&memory_lock);
+    unlink_block(block);
+    pthread_mutex_unlock(&memory_lock);
+    block->magic = 0;
+    free(block);
+}
+
+void* memory_alloc_callback(size_t size, void* user_data)
+{
+    return memory_alloc((MemoryTag)(uintptr_t)user_data, size);
+}
+
+void memory_free_callback(void* ptr, void* user_data)
+{
+    (void)user_data;
+    memory_free(ptr);
+}
+
+void memory_track_buffer(MemoryTag tag, uint32_t id, size_t bytes, const char* label)
+{
+    if (tag >= MEMORY_TAG_COUNT || id == 0) return;
+    pthread_mutex_lock(&memory_lock);
+    if (buffer_count < MEMORY_MAX_BUFFERS) {
+        buffers[buffer_count++] = (MemoryBuffer){ .id = id, .tag = tag, .bytes = bytes, .label = label };
+    }
+    MemoryStats* s = &stats[tag];
+    s->gpu_bytes += bytes;
+    s->gpu_buffers++;
+    if (s->gpu_bytes > s->gpu_peak) s->gpu_peak = s->gpu_bytes;
+    check_budget(tag);
+    pthread_mutex_unlock(&memory_lock);
+}
+
+void memory_release_buffer(uint32_t id)
+{
+    if (id == 0) return;
+    pthread_mutex_lock(&memory_lock);
+    for (uint32_t i = 0; i < buffer_count; i++) {
+        if (buffers[i].id != id) continue;
+        MemoryStats* s = &stats[buffers[i].tag];
+        s->gpu_bytes -= buffers[i].bytes;
+        s->gpu_buffers--;
+        check_budget(buffers[i].tag);
+        buffers[i] = buffers[--buffer_count];
+        break;
+    }
+    pthread_mutex_unlock(&memory_lock);
+}
+
+void memory_set_budget(MemoryTag tag, size_t bytes, uint32_t buffers)
+{
+    if (tag >= MEMORY_TAG_COUNT) return;
+    pthread_mutex_lock(&memory_lock);
+    stats[tag].budget = bytes;
+    stats[tag].buffer_budget = buffers;
+    check_budget(tag);
+    pthread_mutex_unlock(&memory_lock);
+}
+
+bool memory_parse_budget(const char* spec)
+{
+    const char* equals = strchr(spec, '=');
+    if (!equals) return false;
+    size_t length = (size_t)(equals - spec);
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        if (strlen(tag_names[tag]) == length && strncmp(spec, tag_names[tag], length) == 0) {
+            const char* colon = strchr(equals, ':');
+            memory_set_budget((MemoryTag)tag, (size_t)(atof(equals + 1) * MEMORY_MB),
+                              colon ? (uint32_t)atoi(colon + 1) : 0);
+            return true;
+        }
+    }
+    return false;
+}
+
+void memory_get_stats(MemoryTag tag, MemoryStats* out)
+{
+    if (tag >= MEMORY_TAG_COUNT) {
+        *out = (MemoryStats){0};
+        return;
+    }
+    pthread_mutex_lock(&memory_lock);
+    *out = stats[tag];
+    pthread_mutex_unlock(&memory_lock);
+}
+
+uint32_t memory_report_leaks(void)
+{
+    pthread_mutex_lock(&memory_lock);
+    uint32_t leaks = 0;
+    for (int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        const MemoryStats* s = &stats[tag];
+        if (!s->heap_blocks && !s->gpu_buffers) continue;
+        fprintf(stderr, "memory: %s leaked %u heap blocks (%zu bytes) and %u gpu buffers (%zu bytes)\n",
+                tag_names[tag], s->heap_blocks, s->heap_bytes, s->gpu_buffers, s->gpu_bytes);
+        uint32_t listed = 0;
+        for (const MemoryBlock* b = blocks; b && listed < MEMORY_REPORT_LIST; b = b->next) {
+            if (b->tag != (uint32_t)tag) continue;
+            fprintf(stderr, "memory:   heap block of %zu bytes\n", b->size);
+            listed++;
+        }
+        for (uint32_t i = 0; i < buffer_count && listed < MEMORY_REPORT_LIST; i++) {
+            if (buffers[i].tag != (MemoryTag)tag) continue;
+            fprintf(stderr, "memory:   buffer %u \"%s\", %zu bytes\n",
+                    buffers[i].id, buffers[i].label ? buffers[i].label : "", buffers[i].bytes);
+            listed++;
+        }
+        if (s->heap_blocks + s->gpu_buffers > listed) {
+            fprintf(stderr, "memory:   and %u more\n", s->heap_blocks + s->gpu_buffers - listed);
+        }
+        leaks += s->heap_blocks + s->gpu_buffers;
+    }
+    pthread_mutex_unlock(&memory_lock);
+    if (leaks == 0) {
+        printf("memory: no leaks\n");
+    }
+    return leaks;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Memory use by subsystem. Every byte the game owns is charged to a tag:
+  static pools are registered once by the module that owns them, heap
+  blocks go through memory_alloc/memory_free, and GPU buffers are
+  recorded when render.c creates and destroys them. sokol_gfx and
+  sokol_nuklear get the tracking allocator as well, so their internal
+  allocations land under RENDER and GUI.
+
+  Each tag can have a budget covering all three kinds and one on live
+  GPU buffers, which trips long before a few hundred bytes per leaked
+  mesh add up to megabytes. Crossing either prints one warning, dropping
+  back under re-arms it. At exit memory_report_leaks lists the heap
+  blocks and GPU buffers still alive, which is how a mesh made per
+  entity and never destroyed shows up.
+
+  Allocation is rare (init, level loads, buffer creation), so one mutex
+  guards everything and none of this sits on a per-tick path.
+ */
+#define MEMORY_MAX_STATICS 128
+#define MEMORY_MAX_BUFFERS 1024   // Live buffers tracked by id, more stay charged even once destroyed
+
+typedef enum {
+    MEMORY_TAG_ECS,
+    MEMORY_TAG_RENDER,
+    MEMORY_TAG_PHYSICS,
+    MEMORY_TAG_AI,
+    MEMORY_TAG_NET,
+    MEMORY_TAG_EVENTS,
+    MEMORY_TAG_GUI,
+    MEMORY_TAG_LEVEL,
+    MEMORY_TAG_FRAME,
+    MEMORY_TAG_DEBUG,
+    MEMORY_TAG_COUNT
+} MemoryTag;
+
+typedef struct {
+    size_t static_bytes;
+    size_t heap_bytes;
+    size_t heap_peak;
+    uint32_t heap_blocks;
+    size_t gpu_bytes;
+    size_t gpu_peak;
+    uint32_t gpu_buffers;
+    size_t budget;          // Bytes of all three kinds, 0 for none
+    uint32_t buffer_budget; // Live GPU buffers, 0 for none
+    bool over_budget;
+} MemoryStats;
+
+const char* memory_tag_name(MemoryTag tag);
+
+// Charges a static pool to `tag`, registering the same `base` again is ignored
+void memory_register_static(MemoryTag tag, const char* name, const void* base, size_t bytes);
+#define MEMORY_REGISTER_STATIC(tag, object) memory_register_static((tag), #object, &(object), sizeof(object))
+
+// malloc/realloc/free with the block charged to `tag`, memory_free(NULL) does nothing
+void* memory_alloc(MemoryTag tag, size_t size);
+void* memory_realloc(MemoryTag tag, void* ptr, size_t size);
+void memory_free(void* ptr);
+
+// sokol allocator callbacks, `user_data` carries the MemoryTag
+void* memory_alloc_callback(size_t size, void* user_data);
+void memory_free_callback(void* ptr, void* user_data);
+
+// GPU buffers by sokol id, `label` must outlive the buffer
+void memory_track_buffer(MemoryTag tag, uint32_t id, size_t bytes, const char* label);
+void memory_release_buffer(uint32_t id);
+
+void memory_set_budget(MemoryTag tag, size_t bytes, uint32_t buffers);
+// "render=16" sets the render budget to 16 MB, "render=16:64" also allows 64 live buffers,
+// false for an unknown tag
+bool memory_parse_budget(const char* spec);
+
+void memory_get_stats(MemoryTag tag, MemoryStats* out);
+// Prints every live heap block and GPU buffer by tag, returns how many there were
+uint32_t memory_report_leaks(void);
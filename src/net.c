@@ -0,0 +1,1253 @@
+#define _POSIX_C_SOURCE 200809L
+#include "net.h"
+#include "transform.h"
+#include "physics.h"
+#include "projectile.h"
+#include "prediction.h"
+#include "profile.h"
+#include "spatial_hash.h"
+#include "arena.h"
+#include "memory.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+typedef enum {
+    NET_PACKET_HELLO = 1,  // Client join and keepalive
+    NET_PACKET_ACK,
+    NET_PACKET_SNAPSHOT,
+    NET_PACKET_INPUT,      // Followed by `param` PlayerCommands, oldest first
+} NetPacketType;
+
+// Header of every packet. Snapshots cover the chunks [first_chunk, first_chunk + chunk_count)
+// of `tick` and are followed by chunk blocks, acks echo the range they decoded.
+typedef struct {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t first_chunk;
+    uint32_t tick;
+    uint16_t chunk_count;
+    uint16_t param;        // Snapshot: receiver's player slot or NET_NO_PLAYER, hello: view distance
+                           // in units, input: command count
+    uint32_t command;      // Snapshot: newest command applied to the receiver's player
+} NetPacketHeader;
+
+#define NET_NO_BASELINE      0xFFFFFFFFu
+#define NET_PAYLOAD_BYTES    (NET_MAX_PACKET - (uint32_t)sizeof(NetPacketHeader))
+#define CHUNK_COUNT_BITS     5
+#define NET_NO_PLAYER        0xFFFFu
+
+// Entity record ops and the fields a delta record may carry
+enum { OP_DELTA, OP_FULL, OP_REMOVE };
+enum {
+    FIELD_POSITION = 1 << 0,
+    FIELD_ROTATION = 1 << 1,
+    FIELD_SCALE    = 1 << 2,
+    FIELD_HEALTH   = 1 << 3,
+    FIELD_KIND     = 1 << 4,
+    FIELD_SPAWN    = 1 << 5,
+    FIELD_SHAPE    = 1 << 6,
+};
+#define FIELD_BITS 7
+#define KIND_BITS  3
+
+#define QUAT_COMPONENT_BITS 10
+#define QUAT_COMPONENT_MAX  ((1 << QUAT_COMPONENT_BITS) - 1)
+#define SQRT2 1.41421356f
+
+static int sock = -1;
+
+/*
+  Shared helpers
+ */
+double net_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void net_sleep(double seconds)
+{
+    if (seconds <= 0.0) return;
+    struct timespec ts = { .tv_sec = (time_t)seconds, .tv_nsec = (long)((seconds - (double)(time_t)seconds) * 1e9) };
+    nanosleep(&ts, NULL);
+}
+
+static bool open_socket(uint16_t port)
+{
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        perror("net: socket");
+        return false;
+    }
+    struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if (bind(sock, (struct sockaddr*)&local, sizeof(local)) < 0) {
+        perror("net: bind");
+        close(sock);
+        sock = -1;
+        return false;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+}
+
+static bool same_address(const struct sockaddr_in* a, const struct sockaddr_in* b)
+{
+    return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+/*
+  Bit packing
+ */
+typedef struct {
+    uint8_t* data;         // Zeroed by the caller
+    uint32_t bit;
+} BitWriter;
+
+typedef struct {
+    const uint8_t* data;
+    uint32_t bit;
+    uint32_t bit_count;
+    bool overflow;
+} BitReader;
+
+static void bits_write(BitWriter* w, uint32_t value, int count)
+{
+    for (int i = 0; i < count; i++, w->bit++) {
+        if ((value >> i) & 1u) w->data[w->bit >> 3] |= (uint8_t)(1u << (w->bit & 7));
+    }
+}
+
+static uint32_t bits_read(BitReader* r, int count)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < count; i++, r->bit++) {
+        if (r->bit >= r->bit_count) {
+            r->overflow = true;
+            return 0;
+        }
+        if ((r->data[r->bit >> 3] >> (r->bit & 7)) & 1u) value |= 1u << i;
+    }
+    return value;
+}
+
+static void bits_append(BitWriter* w, const uint8_t* data, uint32_t bit_count)
+{
+    for (uint32_t i = 0; i < bit_count; i++, w->bit++) {
+        if ((data[i >> 3] >> (i & 7)) & 1u) w->data[w->bit >> 3] |= (uint8_t)(1u << (w->bit & 7));
+    }
+}
+
+// Unsigned values in one of four widths picked by a 2-bit prefix
+static const int var_widths[4] = { 4, 8, 16, 32 };
+
+static void write_var(BitWriter* w, uint32_t value)
+{
+    uint32_t width = value < (1u << 4) ? 0 : value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : 3;
+    bits_write(w, width, 2);
+    bits_write(w, value, var_widths[width]);
+}
+
+static uint32_t read_var(BitReader* r)
+{
+    return bits_read(r, var_widths[bits_read(r, 2)]);
+}
+
+static uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1u);
+}
+
+// Wrapping difference, quantized values can be far apart after a teleport
+static int32_t diff(int32_t a, int32_t b)
+{
+    return (int32_t)((uint32_t)a - (uint32_t)b);
+}
+
+/*
+  Quantization
+ */
+static int32_t quantize(float v)
+{
+    return (int32_t)lroundf(v * NET_POSITION_SCALE);
+}
+
+static float dequantize(int32_t v)
+{
+    return (float)v / NET_POSITION_SCALE;
+}
+
+// Drops the largest component, it is rebuilt from the unit length on unpack
+static uint32_t quat_pack(const float q[4])
+{
+    static const float identity[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    float length = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    if (length <= 0.0f) {
+        // No rotation at all, sent as the identity
+        q = identity;
+        length = 1.0f;
+    }
+
+    int largest = 0;
+    for (int i = 1; i < 4; i++) {
+        if (fabsf(q[i]) > fabsf(q[largest])) largest = i;
+    }
+    // q and -q are the same rotation, flip so the dropped component is positive
+    float scale = (q[largest] < 0.0f ? -1.0f : 1.0f) / length;
+
+    uint32_t packed = (uint32_t)largest;
+    int shift = 2;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest) continue;
+        // The others are within +-1/sqrt(2)
+        float v = q[i] * scale * SQRT2 * 0.5f + 0.5f;
+        long bits = lroundf(v * QUAT_COMPONENT_MAX);
+        bits = bits < 0 ? 0 : bits > QUAT_COMPONENT_MAX ? QUAT_COMPONENT_MAX : bits;
+        packed |= (uint32_t)bits << shift;
+        shift += QUAT_COMPONENT_BITS;
+    }
+    return packed;
+}
+
+static void quat_unpack(uint32_t packed, float out[4])
+{
+    int largest = (int)(packed & 3u);
+    int shift = 2;
+    float sum = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest) continue;
+        float v = (float)((packed >> shift) & QUAT_COMPONENT_MAX) / QUAT_COMPONENT_MAX;
+        out[i] = (v - 0.5f) * 2.0f / SQRT2;
+        sum += out[i] * out[i];
+        shift += QUAT_COMPONENT_BITS;
+    }
+    out[largest] = sqrtf(fmaxf(0.0f, 1.0f - sum));
+}
+
+static NetKind entity_kind(Entity e)
+{
+    uint32_t mask = registry.component_masks[e];
+    if (mask & COMPONENT_ZOMBIE) return NET_KIND_ZOMBIE;
+    if (mask & COMPONENT_PROJECTILE) return NET_KIND_PROJECTILE;
+    const CollisionComponent* c = entity_get_collision(e);
+    if (c->is_static) return NET_KIND_STATIC;
+    if (c->layer & PHYSICS_LAYER_PLAYER) return NET_KIND_PLAYER;
+    return NET_KIND_OTHER;
+}
+
+// Every physical entity is replicated, cameras and other local-only entities are not
+static void capture_world(NetEntityState* out)
+{
+    const uint32_t replicated = COMPONENT_TRANSFORM | COMPONENT_COLLISION;
+    memset(out, 0, sizeof(NetEntityState) * MAX_ENTITIES);
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        if (!entity_is_alive(e) || (registry.component_masks[e] & replicated) != replicated) continue;
+        const TransformComponent* t = entity_get_transform(e);
+        const CollisionComponent* c = entity_get_collision(e);
+        const HealthComponent* h = entity_get_health(e);
+        NetEntityState* s = &out[e];
+        s->present = 1;
+        s->generation = entity_generation(e);
+        for (int i = 0; i < 3; i++) {
+            s->position[i] = quantize(t->position[i]);
+            s->scale[i] = quantize(t->scale[i]);
+            s->size[i] = quantize(c->size[i]);
+        }
+        s->rotation = quat_pack(t->rotation);
+        s->layer = c->layer;
+        s->mask = c->mask;
+        if (h) {
+            float quarters = h->current_health * 4.0f;
+            s->health = (uint16_t)(quarters <= 0.0f ? 0.0f : quarters >= NET_NO_HEALTH - 1 ? NET_NO_HEALTH - 1 : quarters);
+        } else {
+            s->health = NET_NO_HEALTH;
+        }
+        s->kind = (uint8_t)entity_kind(e);
+
+        // Lets the owning client match the projectile with the one it predicted
+        const ProjectileComponent* p = entity_get_projectile(e);
+        if (p && p->command && p->owner != INVALID_ENTITY) {
+            s->owner = (uint16_t)(p->owner + 1);
+            s->command = (uint16_t)p->command;
+        }
+    }
+}
+
+/*
+  Entity records
+ */
+static uint32_t changed_fields(const NetEntityState* base, const NetEntityState* s)
+{
+    uint32_t fields = 0;
+    if (memcmp(base->position, s->position, sizeof(s->position)) != 0) fields |= FIELD_POSITION;
+    if (base->rotation != s->rotation) fields |= FIELD_ROTATION;
+    if (memcmp(base->scale, s->scale, sizeof(s->scale)) != 0) fields |= FIELD_SCALE;
+    if (base->health != s->health) fields |= FIELD_HEALTH;
+    if (base->kind != s->kind) fields |= FIELD_KIND;
+    if (base->owner != s->owner || base->command != s->command) fields |= FIELD_SPAWN;
+    if (memcmp(base->size, s->size, sizeof(s->size)) != 0 || base->layer != s->layer || base->mask != s->mask) {
+        fields |= FIELD_SHAPE;
+    }
+    return fields;
+}
+
+static void write_fields(BitWriter* w, const NetEntityState* base, const NetEntityState* s, uint32_t fields)
+{
+    if (fields & FIELD_POSITION) {
+        for (int i = 0; i < 3; i++) write_var(w, zigzag(diff(s->position[i], base->position[i])));
+    }
+    if (fields & FIELD_ROTATION) bits_write(w, s->rotation, 32);
+    if (fields & FIELD_SCALE) {
+        for (int i = 0; i < 3; i++) write_var(w, zigzag(diff(s->scale[i], base->scale[i])));
+    }
+    if (fields & FIELD_HEALTH) bits_write(w, s->health, 16);
+    if (fields & FIELD_KIND) bits_write(w, s->kind, KIND_BITS);
+    if (fields & FIELD_SPAWN) {
+        write_var(w, s->owner);
+        bits_write(w, s->command, 16);
+    }
+    if (fields & FIELD_SHAPE) {
+        for (int i = 0; i < 3; i++) write_var(w, zigzag(diff(s->size[i], base->size[i])));
+        write_var(w, s->layer);
+        write_var(w, s->mask);
+    }
+}
+
+static void read_fields(BitReader* r, NetEntityState* s, uint32_t fields)
+{
+    if (fields & FIELD_POSITION) {
+        for (int i = 0; i < 3; i++) s->position[i] = (int32_t)((uint32_t)s->position[i] + (uint32_t)unzigzag(read_var(r)));
+    }
+    if (fields & FIELD_ROTATION) s->rotation = bits_read(r, 32);
+    if (fields & FIELD_SCALE) {
+        for (int i = 0; i < 3; i++) s->scale[i] = (int32_t)((uint32_t)s->scale[i] + (uint32_t)unzigzag(read_var(r)));
+    }
+    if (fields & FIELD_HEALTH) s->health = (uint16_t)bits_read(r, 16);
+    if (fields & FIELD_KIND) s->kind = (uint8_t)bits_read(r, KIND_BITS);
+    if (fields & FIELD_SPAWN) {
+        s->owner = (uint16_t)read_var(r);
+        s->command = (uint16_t)bits_read(r, 16);
+    }
+    if (fields & FIELD_SHAPE) {
+        for (int i = 0; i < 3; i++) s->size[i] = (int32_t)((uint32_t)s->size[i] + (uint32_t)unzigzag(read_var(r)));
+        s->layer = read_var(r);
+        s->mask = read_var(r);
+    }
+}
+
+
+// Op turning `base` into `target`, -1 when there is nothing to send
+static int record_op(const NetEntityState* base, const NetEntityState* target, uint32_t* out_fields)
+{
+    static const NetEntityState empty;
+    *out_fields = 0;
+    if (!target->present) return base->present ? OP_REMOVE : -1;
+    if (!base->present || base->generation != target->generation) {
+        *out_fields = changed_fields(&empty, target);
+        return OP_FULL;
+    }
+    *out_fields = changed_fields(base, target);
+    return *out_fields ? OP_DELTA : -1;
+}
+
+static void write_record(BitWriter* w, int op, uint32_t fields, const NetEntityState* base, const NetEntityState* target)
+{
+    static const NetEntityState empty;
+    bits_write(w, (uint32_t)op, 2);
+    if (op == OP_FULL) {
+        write_var(w, target->generation);
+        bits_write(w, fields, FIELD_BITS);
+        write_fields(w, &empty, target, fields);
+    } else if (op == OP_DELTA) {
+        bits_write(w, fields, FIELD_BITS);
+        write_fields(w, base, target, fields);
+    }
+}
+
+// Writes the records that turn `base` into `target`, both indexed within one chunk, returns how many
+static uint32_t encode_chunk(BitWriter* w, const NetEntityState* base, const NetEntityState* target)
+{
+    int32_t previous = -1;
+    uint32_t count = 0;
+    for (int32_t i = 0; i < NET_CHUNK_ENTITIES; i++) {
+        uint32_t fields;
+        int op = record_op(&base[i], &target[i], &fields);
+        if (op < 0) continue;
+        write_var(w, (uint32_t)(i - previous - 1));
+        write_record(w, op, fields, &base[i], &target[i]);
+        previous = i;
+        count++;
+    }
+    return count;
+}
+
+// Applies `count` records of one chunk to `states`, which already hold the chunk's baseline
+static bool decode_chunk(BitReader* r, NetEntityState* states, uint32_t chunk, uint32_t count)
+{
+    static const NetEntityState empty;
+    int32_t end = (int32_t)((chunk + 1) * NET_CHUNK_ENTITIES);
+    int32_t previous = (int32_t)(chunk * NET_CHUNK_ENTITIES) - 1;
+
+    for (uint32_t i = 0; i < count; i++) {
+        // Records only move forward and stay inside the chunk, anything else is malformed
+        uint32_t gap = read_var(r);
+        uint32_t op = bits_read(r, 2);
+        if (r->overflow || gap >= (uint32_t)(end - previous - 1) || op > OP_REMOVE) return false;
+        int32_t id = previous + 1 + (int32_t)gap;
+
+        NetEntityState* s = &states[id];
+        if (op == OP_REMOVE) {
+            *s = empty;
+        } else if (op == OP_FULL) {
+            *s = empty;
+            s->present = 1;
+            s->generation = read_var(r);
+            read_fields(r, s, bits_read(r, FIELD_BITS));
+        } else {
+            read_fields(r, s, bits_read(r, FIELD_BITS));
+        }
+        previous = id;
+    }
+    return !r->overflow;
+}
+
+static uint32_t history_slot(uint32_t tick)
+{
+    return (tick / NET_SNAPSHOT_INTERVAL) & (NET_HISTORY - 1);
+}
+
+// Wrapping tick order, anything is newer than NET_NO_BASELINE
+static bool tick_newer(uint32_t tick, uint32_t than)
+{
+    return than == NET_NO_BASELINE || (int32_t)(tick - than) > 0;
+}
+
+/*
+  Server
+ */
+typedef struct {
+    bool active;
+    struct sockaddr_in address;
+    Entity player;                      // Viewpoint from the join callback, INVALID_ENTITY sees everything
+    float view_distance;
+    double last_heard;
+    uint32_t chunk_acked[NET_CHUNKS];   // Newest acknowledged snapshot per chunk, NET_NO_BASELINE for none
+    // What the client holds after each snapshot: the global snapshot every entity's state
+    // came from, NET_NO_BASELINE when absent. Chunks not set in view_chunks hold nothing.
+    uint32_t view[NET_HISTORY][MAX_ENTITIES];
+    uint8_t view_chunks[NET_HISTORY][NET_CHUNKS / 8];
+    uint32_t last_sent[MAX_ENTITIES];   // Snapshot each entity was last updated in
+    PlayerCommand commands[NET_COMMAND_BUFFER];  // Queued by sequence
+    uint32_t command_applied;           // Newest command applied to the player, 0 for none
+    uint32_t command_received;
+    uint64_t bytes_this_second;
+    uint32_t snapshots_this_second;
+    uint32_t relevant;                  // Counts from the latest snapshot, for the stats line
+    uint32_t deferred;
+} NetClient;
+
+typedef struct {
+    Entity entity;
+    float priority;
+    uint32_t bits;
+    bool forced;
+} Candidate;
+
+static NetClient clients[NET_MAX_CLIENTS];
+static NetEntityState history[NET_HISTORY][MAX_ENTITIES];
+static uint32_t history_tick[NET_HISTORY];
+static NetJoinCallback join_callback;
+static NetLeaveCallback leave_callback;
+static uint32_t budget_bytes = NET_CLIENT_BUDGET;
+static double stats_time;
+
+// Replicated entities bucketed by bounds, rebuilt each snapshot for the relevance queries
+static SpatialHash interest;
+static uint32_t bucket_stamp[SPATIAL_HASH_BUCKETS];
+static uint32_t bucket_serial;
+static uint32_t relevant_stamp[MAX_ENTITIES];
+static uint32_t relevant_serial;
+
+// Datagram being filled for the current client
+static uint8_t packet_data[NET_MAX_PACKET];
+static NetPacketHeader packet_header;
+static BitWriter packet_bits;
+static uint32_t packet_age;
+
+static bool chunk_bit(const uint8_t* bits, uint32_t chunk)
+{
+    return (bits[chunk >> 3] >> (chunk & 7)) & 1u;
+}
+
+bool net_server_open(uint16_t port, NetJoinCallback on_join, NetLeaveCallback on_leave)
+{
+    if (!open_socket(port)) return false;
+    memset(clients, 0, sizeof(clients));
+    memset(history_tick, 0xff, sizeof(history_tick));
+    join_callback = on_join;
+    leave_callback = on_leave;
+    stats_time = net_time();
+
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_NET, clients);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_NET, history);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_NET, interest);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_NET, bucket_stamp);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_NET, relevant_stamp);
+    return true;
+}
+
+void net_server_close(void)
+{
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        if (clients[i].active && leave_callback) leave_callback(i, clients[i].player);
+        clients[i].active = false;
+    }
+    if (sock >= 0) close(sock);
+    sock = -1;
+}
+
+void net_server_set_budget(uint32_t bytes_per_second)
+{
+    budget_bytes = bytes_per_second;
+}
+
+static NetClient* find_client(const struct sockaddr_in* address)
+{
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        if (clients[i].active && same_address(&clients[i].address, address)) return &clients[i];
+    }
+    return NULL;
+}
+
+static NetClient* add_client(const struct sockaddr_in* address)
+{
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        NetClient* c = &clients[i];
+        if (c->active) continue;
+        c->active = true;
+        c->address = *address;
+        c->view_distance = NET_MAX_VIEW_DISTANCE;
+        c->bytes_this_second = 0;
+        c->snapshots_this_second = 0;
+        memset(c->chunk_acked, 0xff, sizeof(c->chunk_acked));
+        memset(c->view_chunks, 0, sizeof(c->view_chunks));
+        memset(c->last_sent, 0xff, sizeof(c->last_sent));
+        memset(c->commands, 0, sizeof(c->commands));
+        c->command_applied = 0;
+        c->command_received = 0;
+        c->player = join_callback ? join_callback(i) : INVALID_ENTITY;
+        printf("net: client %d connected from %s:%u\n", i, inet_ntoa(address->sin_addr), ntohs(address->sin_port));
+        return c;
+    }
+    return NULL;
+}
+
+// Queues the commands of an input packet that are newer than what the player got
+static void receive_commands(NetClient* c, const uint8_t* data, uint32_t size, uint32_t count)
+{
+    if (size != sizeof(NetPacketHeader) + count * sizeof(PlayerCommand)) return;
+    for (uint32_t i = 0; i < count; i++) {
+        PlayerCommand command;
+        memcpy(&command, data + sizeof(NetPacketHeader) + i * sizeof(PlayerCommand), sizeof(command));
+        uint32_t ahead = command.sequence - c->command_applied;
+        if (ahead == 0 || ahead > NET_COMMAND_BUFFER) continue;
+        c->commands[command.sequence & (NET_COMMAND_BUFFER - 1)] = command;
+        if ((int32_t)(command.sequence - c->command_received) > 0) c->command_received = command.sequence;
+    }
+}
+
+void net_server_poll(void)
+{
+    double now = net_time();
+    static uint8_t data[NET_MAX_PACKET];
+    NetPacketHeader packet;
+    struct sockaddr_in from;
+    socklen_t from_size = sizeof(from);
+    ssize_t n;
+    while ((n = recvfrom(sock, data, sizeof(data), 0, (struct sockaddr*)&from, &from_size)) >= 0) {
+        from_size = sizeof(from);
+        if (n < (ssize_t)sizeof(packet)) continue;
+        memcpy(&packet, data, sizeof(packet));
+        NetClient* client = find_client(&from);
+        if (!client && packet.type == NET_PACKET_HELLO) client = add_client(&from);
+        if (!client) continue;
+
+        client->last_heard = now;
+        if (packet.type == NET_PACKET_INPUT) {
+            receive_commands(client, data, (uint32_t)n, packet.param);
+            continue;
+        }
+        if (n != (ssize_t)sizeof(packet)) continue;
+        if (packet.type == NET_PACKET_HELLO) {
+            float requested = packet.param ? (float)packet.param : NET_MAX_VIEW_DISTANCE;
+            client->view_distance = requested < NET_MAX_VIEW_DISTANCE ? requested : NET_MAX_VIEW_DISTANCE;
+        }
+        // Acks for snapshots that already left the history can never be baselines
+        if (packet.type != NET_PACKET_ACK || history_tick[history_slot(packet.tick)] != packet.tick ||
+            packet.first_chunk >= NET_CHUNKS || packet.chunk_count > NET_CHUNKS - packet.first_chunk) {
+            continue;
+        }
+        for (uint32_t chunk = packet.first_chunk; chunk < (uint32_t)packet.first_chunk + packet.chunk_count; chunk++) {
+            if (tick_newer(packet.tick, client->chunk_acked[chunk])) client->chunk_acked[chunk] = packet.tick;
+        }
+    }
+
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        if (clients[i].active && now - clients[i].last_heard > NET_CLIENT_TIMEOUT) {
+            printf("net: client %d timed out\n", i);
+            clients[i].active = false;
+            if (leave_callback) leave_callback(i, clients[i].player);
+        }
+    }
+}
+
+void net_server_apply_commands(float delta_time)
+{
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        NetClient* c = &clients[i];
+        if (!c->active || c->player == INVALID_ENTITY) continue;
+
+        for (int applied = 0; applied < NET_TICK_COMMANDS;) {
+            uint32_t next = c->command_applied + 1;
+            const PlayerCommand* command = &c->commands[next & (NET_COMMAND_BUFFER - 1)];
+            if (command->sequence != next) {
+                // Lost along with every resend, don't stall the player behind it forever
+                if (c->command_received - c->command_applied <= NET_COMMAND_BUFFER / 2) break;
+                c->command_applied = next;
+                continue;
+            }
+            input_apply_command(c->player, command, delta_time);
+            ShootEvent shot;
+            if (input_command_shot(c->player, command, &shot)) {
+                event_send(EVENT_SHOOT, &shot);
+            }
+            c->command_applied = next;
+            applied++;
+        }
+    }
+}
+
+// Buckets every replicated entity by its bounds, shared by all clients' relevance queries
+static void build_interest(const NetEntityState* current)
+{
+    spatial_hash_begin(&interest, NET_INTEREST_CELL_SIZE);
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        if (!current[e].present) continue;
+        const CollisionComponent* c = entity_get_collision(e);
+        spatial_hash_insert_aabb(&interest, e, c->min, c->max);
+    }
+    spatial_hash_end(&interest);
+}
+
+// Stamps the entities whose bounds are within the client's view distance and sets their
+// chunks in out_chunks. Only the cells around the viewer are visited.
+static uint32_t find_relevant(const NetClient* c, const NetEntityState* current, uint8_t* out_chunks)
+{
+    relevant_serial++;
+    memset(out_chunks, 0, NET_CHUNKS / 8);
+    uint32_t count = 0;
+
+    const TransformComponent* viewer = c->player != INVALID_ENTITY ? entity_get_transform(c->player) : NULL;
+    if (!viewer) {
+        for (Entity e = 0; e < MAX_ENTITIES; e++) {
+            if (!current[e].present) continue;
+            relevant_stamp[e] = relevant_serial;
+            out_chunks[e / NET_CHUNK_ENTITIES >> 3] |= (uint8_t)(1u << (e / NET_CHUNK_ENTITIES & 7));
+            count++;
+        }
+        return count;
+    }
+
+    float x = viewer->position[0], z = viewer->position[2], r = c->view_distance;
+    int x0 = spatial_hash_coord(&interest, x - r), x1 = spatial_hash_coord(&interest, x + r);
+    int z0 = spatial_hash_coord(&interest, z - r), z1 = spatial_hash_coord(&interest, z + r);
+    bucket_serial++;
+    for (int cz = z0; cz <= z1; cz++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            uint32_t bucket = spatial_hash_bucket(cx, cz);
+            if (bucket_stamp[bucket] == bucket_serial) continue;
+            bucket_stamp[bucket] = bucket_serial;
+
+            uint32_t n;
+            const Entity* entries = spatial_hash_bucket_entries(&interest, bucket, &n);
+            for (uint32_t i = 0; i < n; i++) {
+                Entity e = entries[i];
+                if (relevant_stamp[e] == relevant_serial) continue;
+                const CollisionComponent* col = entity_get_collision(e);
+                float dx = x < col->min[0] ? col->min[0] - x : x > col->max[0] ? x - col->max[0] : 0.0f;
+                float dz = z < col->min[2] ? col->min[2] - z : z > col->max[2] ? z - col->max[2] : 0.0f;
+                if (dx * dx + dz * dz > r * r) continue;
+                relevant_stamp[e] = relevant_serial;
+                out_chunks[e / NET_CHUNK_ENTITIES >> 3] |= (uint8_t)(1u << (e / NET_CHUNK_ENTITIES & 7));
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+// State the client held for e after snapshot `tick`, NULL when absent
+static const NetEntityState* view_state(const NetClient* c, uint32_t tick, Entity e)
+{
+    if (tick == NET_NO_BASELINE || !chunk_bit(c->view_chunks[history_slot(tick)], e / NET_CHUNK_ENTITIES)) return NULL;
+    uint32_t source = c->view[history_slot(tick)][e];
+    return source == NET_NO_BASELINE ? NULL : &history[history_slot(source)][e];
+}
+
+// Newest acked snapshot of a chunk usable as its baseline, NET_NO_BASELINE to send it against nothing
+static uint32_t chunk_baseline(const NetClient* c, uint32_t chunk, uint32_t tick)
+{
+    uint32_t acked = c->chunk_acked[chunk];
+    if (acked == NET_NO_BASELINE || acked == tick || history_tick[history_slot(acked)] != acked) return NET_NO_BASELINE;
+    // Entities the budget kept back may hold states from before the acked snapshot
+    if (chunk_bit(c->view_chunks[history_slot(acked)], chunk)) {
+        const uint32_t* view = c->view[history_slot(acked)];
+        for (Entity e = chunk * NET_CHUNK_ENTITIES; e < (chunk + 1) * NET_CHUNK_ENTITIES; e++) {
+            if (view[e] != NET_NO_BASELINE && history_tick[history_slot(view[e])] != view[e]) return NET_NO_BASELINE;
+        }
+    }
+    return acked;
+}
+
+static int compare_candidates(const void* a, const void* b)
+{
+    const Candidate* ca = a;
+    const Candidate* cb = b;
+    if (ca->priority != cb->priority) return ca->priority > cb->priority ? -1 : 1;
+    return ca->entity < cb->entity ? -1 : ca->entity > cb->entity;
+}
+
+static void packet_begin(uint32_t tick, uint32_t first_chunk)
+{
+    memset(packet_data, 0, sizeof(packet_data));
+    packet_header = (NetPacketHeader){ .type = NET_PACKET_SNAPSHOT, .tick = tick, .first_chunk = (uint16_t)first_chunk };
+    packet_bits = (BitWriter){ .data = packet_data + sizeof(NetPacketHeader) };
+    packet_age = 0;
+}
+
+static void packet_send(NetClient* c)
+{
+    if (!packet_header.chunk_count) return;
+    uint32_t size = (uint32_t)sizeof(NetPacketHeader) + (packet_bits.bit + 7) / 8;
+    packet_header.param = c->player != INVALID_ENTITY ? (uint16_t)c->player : NET_NO_PLAYER;
+    packet_header.command = c->command_applied;
+    memcpy(packet_data, &packet_header, sizeof(packet_header));
+    sendto(sock, packet_data, size, 0, (const struct sockaddr*)&c->address, sizeof(c->address));
+    c->bytes_this_second += size;
+}
+
+// A block starts with its baseline age in snapshots (0 for none, 1 bit when it repeats
+// the previous block's) and a record count. It then holds one chunk's records, or for a
+// count of zero, the length of a run of unchanged chunks sharing that baseline.
+static void write_block(NetClient* c, uint32_t first_chunk, uint32_t chunks, uint32_t age,
+                        uint32_t count, const uint8_t* records, uint32_t record_bits)
+{
+    static uint8_t block[NET_MAX_PACKET];
+    for (;;) {
+        memset(block, 0, sizeof(block));
+        BitWriter b = { .data = block };
+        bits_write(&b, age == packet_age, 1);
+        if (age != packet_age) write_var(&b, age);
+        bits_write(&b, count, CHUNK_COUNT_BITS);
+        if (count) {
+            bits_append(&b, records, record_bits);
+        } else {
+            write_var(&b, chunks - 1);
+        }
+
+        // A block always fits an empty packet, NET_CHUNK_ENTITIES keeps the worst case well under
+        if (packet_bits.bit + b.bit > NET_PAYLOAD_BYTES * 8 && packet_header.chunk_count) {
+            packet_send(c);
+            packet_begin(packet_header.tick, first_chunk);
+            continue;
+        }
+        bits_append(&packet_bits, block, b.bit);
+        packet_header.chunk_count = (uint16_t)(packet_header.chunk_count + chunks);
+        packet_age = age;
+        return;
+    }
+}
+
+// Decides what the client holds after snapshot `tick`: relevant entities that changed
+// compete for the budget by staleness and distance, removals are always sent
+// `candidates` is scratch for MAX_ENTITIES, shared by every client of the snapshot. Without
+// it (frame arena full) everything that changed is sent, over budget rather than stale.
+static void select_view(NetClient* c, uint32_t tick, const NetEntityState* current, const uint32_t* baselines,
+                        Candidate* candidates)
+{
+    static const NetEntityState empty;
+    static uint8_t scratch[64];
+    uint8_t relevant_chunks[NET_CHUNKS / 8];
+    uint32_t slot = history_slot(tick);
+    uint32_t* view = c->view[slot];
+    uint8_t* view_chunks = c->view_chunks[slot];
+    c->relevant = find_relevant(c, current, relevant_chunks);
+
+    const TransformComponent* viewer = c->player != INVALID_ENTITY ? entity_get_transform(c->player) : NULL;
+    uint32_t count = 0;
+    memset(view_chunks, 0, NET_CHUNKS / 8);
+    for (uint32_t chunk = 0; chunk < NET_CHUNKS; chunk++) {
+        uint32_t baseline = baselines[chunk];
+        bool held = baseline != NET_NO_BASELINE && chunk_bit(c->view_chunks[history_slot(baseline)], chunk);
+        if (!held && !chunk_bit(relevant_chunks, chunk)) continue;
+        view_chunks[chunk >> 3] |= (uint8_t)(1u << (chunk & 7));
+
+        for (Entity e = chunk * NET_CHUNK_ENTITIES; e < (chunk + 1) * NET_CHUNK_ENTITIES; e++) {
+            const NetEntityState* base = held ? view_state(c, baseline, e) : NULL;
+            const NetEntityState* target = relevant_stamp[e] == relevant_serial ? &current[e] : &empty;
+            uint32_t fields;
+            int op = record_op(base ? base : &empty, target, &fields);
+            if (op < 0 || op == OP_REMOVE) {
+                view[e] = target->present ? tick : NET_NO_BASELINE;
+                continue;
+            }
+            if (!candidates) {
+                view[e] = tick;
+                c->last_sent[e] = tick;
+                continue;
+            }
+            // Kept back unless it wins the budget below
+            view[e] = base ? c->view[history_slot(baseline)][e] : NET_NO_BASELINE;
+
+            BitWriter w = { .data = scratch };
+            write_record(&w, op, fields, base ? base : &empty, target);
+            memset(scratch, 0, (w.bit + 7) / 8);
+
+            float staleness = c->last_sent[e] == NET_NO_BASELINE ? (float)NET_HISTORY
+                            : (float)((tick - c->last_sent[e]) / NET_SNAPSHOT_INTERVAL);
+            float distance = 0.0f;
+            if (viewer) {
+                float dx = dequantize(target->position[0]) - viewer->position[0];
+                float dz = dequantize(target->position[2]) - viewer->position[2];
+                distance = sqrtf(dx * dx + dz * dz);
+            }
+            candidates[count++] = (Candidate){
+                .entity = e,
+                .priority = staleness / (1.0f + distance / NET_PRIORITY_FALLOFF),
+                .bits = w.bit + 8, // Gap to the previous record
+                // A held state must be refreshed before its snapshot leaves the history. The
+                // client's player and shots are what its prediction is checked against.
+                .forced = (base && staleness >= NET_HISTORY / 2) || e == c->player ||
+                          (target->owner && target->owner - 1u == c->player),
+            };
+        }
+    }
+
+    c->deferred = 0;
+    if (!candidates) return;
+    qsort(candidates, count, sizeof(Candidate), compare_candidates);
+    uint32_t budget = budget_bytes * 8 / (NET_TICK_RATE / NET_SNAPSHOT_INTERVAL);
+    uint32_t spent = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const Candidate* candidate = &candidates[i];
+        if (!candidate->forced && spent + candidate->bits > budget) {
+            c->deferred++;
+            continue;
+        }
+        spent += candidate->bits;
+        view[candidate->entity] = tick;
+        c->last_sent[candidate->entity] = tick;
+    }
+}
+
+// Sends the client's view of snapshot `tick` as chunks, each against its newest acknowledged copy
+static void send_snapshot(NetClient* c, uint32_t tick, const NetEntityState* current, Candidate* candidates)
+{
+    static const NetEntityState empty;
+    static uint32_t baselines[NET_CHUNKS];
+    static uint8_t records[NET_MAX_PACKET];
+    NetEntityState base[NET_CHUNK_ENTITIES];
+    NetEntityState target[NET_CHUNK_ENTITIES];
+
+    for (uint32_t chunk = 0; chunk < NET_CHUNKS; chunk++) {
+        baselines[chunk] = chunk_baseline(c, chunk, tick);
+    }
+    select_view(c, tick, current, baselines, candidates);
+
+    const uint32_t* view = c->view[history_slot(tick)];
+    const uint8_t* view_chunks = c->view_chunks[history_slot(tick)];
+    uint32_t run_first = 0, run_length = 0, run_age = 0;
+    packet_begin(tick, 0);
+    for (uint32_t chunk = 0; chunk < NET_CHUNKS; chunk++) {
+        uint32_t baseline = baselines[chunk];
+        uint32_t age = baseline != NET_NO_BASELINE ? (tick - baseline) / NET_SNAPSHOT_INTERVAL : 0;
+        uint32_t count = 0;
+        BitWriter r = { .data = records };
+        if (chunk_bit(view_chunks, chunk)) {
+            for (uint32_t i = 0; i < NET_CHUNK_ENTITIES; i++) {
+                Entity e = chunk * NET_CHUNK_ENTITIES + i;
+                const NetEntityState* b = view_state(c, baseline, e);
+                base[i] = b ? *b : empty;
+                target[i] = view[e] != NET_NO_BASELINE ? history[history_slot(view[e])][e] : empty;
+            }
+            count = encode_chunk(&r, base, target);
+        } else {
+            age = 0; // Empty on both sides, any baseline decodes the same
+        }
+
+        if (count == 0 && run_length && age == run_age) {
+            run_length++;
+            continue;
+        }
+        if (run_length) write_block(c, run_first, run_length, run_age, 0, NULL, 0);
+        run_length = 0;
+        if (count == 0) {
+            run_first = chunk;
+            run_length = 1;
+            run_age = age;
+        } else {
+            write_block(c, chunk, 1, age, count, records, r.bit);
+            memset(records, 0, (r.bit + 7) / 8);
+        }
+    }
+    if (run_length) write_block(c, run_first, run_length, run_age, 0, NULL, 0);
+    packet_send(c);
+}
+
+static void print_stats(double now, const NetEntityState* latest)
+{
+    double elapsed = now - stats_time;
+    uint32_t replicated = 0;
+    for (Entity e = 0; e < MAX_ENTITIES; e++) replicated += latest[e].present;
+
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        NetClient* c = &clients[i];
+        if (!c->active) continue;
+        printf("net: client %d %.1f KB/s, %u snapshots/s, %u/%u entities relevant, %u deferred\n",
+               i, (double)c->bytes_this_second / 1024.0 / elapsed, c->snapshots_this_second,
+               c->relevant, replicated, c->deferred);
+        c->bytes_this_second = 0;
+        c->snapshots_this_second = 0;
+    }
+    stats_time = now;
+}
+
+void net_server_send_snapshots(uint32_t tick)
+{
+    if (sock < 0 || tick % NET_SNAPSHOT_INTERVAL != 0) return;
+    PROFILE_BEGIN("net_server_send_snapshots");
+
+    uint32_t slot = history_slot(tick);
+    capture_world(history[slot]);
+    history_tick[slot] = tick;
+    build_interest(history[slot]);
+
+    Candidate* candidates = ARENA_ALLOC(frame_arena(), Candidate, MAX_ENTITIES);
+    for (int i = 0; i < NET_MAX_CLIENTS; i++) {
+        NetClient* c = &clients[i];
+        if (!c->active) continue;
+        send_snapshot(c, tick, history[slot], candidates);
+        c->snapshots_this_second++;
+    }
+
+    double now = net_time();
+    if (now - stats_time >= 1.0) print_stats(now, history[slot]);
+    PROFILE_END("net_server_send_snapshots");
+}
+
+/*
+  Client
+ */
+typedef struct {
+    uint32_t tick;                     // NET_NO_BASELINE for an unused slot
+    uint8_t received[NET_CHUNKS / 8];  // Chunks decoded for this tick, the rest of states is stale
+    NetEntityState states[MAX_ENTITIES];
+} ClientSnapshot;
+
+static ClientSnapshot client_snapshots[NET_HISTORY];
+static uint32_t chunk_applied[NET_CHUNKS];
+static struct sockaddr_in server_address;
+static bool client_connected;
+static double last_sent;
+static uint16_t client_view_distance;
+
+static PlayerCommand sent_commands[NET_COMMAND_BUFFER];
+static uint32_t command_newest;   // Newest command sent, 0 before the first
+static uint32_t command_acked;    // Newest command the server applied
+
+// Server entity slot to the local entity replicating it
+static Entity local_entities[MAX_ENTITIES];
+static uint32_t local_generations[MAX_ENTITIES];
+static Entity client_player = INVALID_ENTITY;
+
+static uint64_t client_bytes_this_second;
+static uint32_t client_snapshots_this_second;
+
+static void client_send(uint8_t type, uint32_t tick, uint32_t first_chunk, uint32_t chunk_count)
+{
+    NetPacketHeader packet = { .type = type, .tick = tick, .first_chunk = (uint16_t)first_chunk, .chunk_count = (uint16_t)chunk_count,
+                               .param = type == NET_PACKET_HELLO ? client_view_distance : 0 };
+    sendto(sock, &packet, sizeof(packet), 0, (const struct sockaddr*)&server_address, sizeof(server_address));
+    last_sent = net_time();
+}
+
+bool net_client_open(const char* address, float view_distance)
+{
+    char host[256];
+    const char* port = NULL;
+    const char* colon = strrchr(address, ':');
+    size_t host_length = colon ? (size_t)(colon - address) : strlen(address);
+    if (host_length >= sizeof(host)) return false;
+    memcpy(host, address, host_length);
+    host[host_length] = '\0';
+    char default_port[8];
+    snprintf(default_port, sizeof(default_port), "%u", NET_DEFAULT_PORT);
+    port = colon ? colon + 1 : default_port;
+
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_DGRAM };
+    struct addrinfo* result = NULL;
+    if (getaddrinfo(host, port, &hints, &result) != 0 || !result) {
+        fprintf(stderr, "net: cannot resolve %s\n", address);
+        return false;
+    }
+    memcpy(&server_address, result->ai_addr, sizeof(server_address));
+    freeaddrinfo(result);
+
+    if (!open_socket(0)) return false;
+    for (uint32_t i = 0; i < NET_HISTORY; i++) {
+        client_snapshots[i].tick = NET_NO_BASELINE;
+    }
+    memset(chunk_applied, 0xff, sizeof(chunk_applied));
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        local_entities[e] = INVALID_ENTITY;
+    }
+    client_player = INVALID_ENTITY;
+    command_newest = 0;
+    command_acked = 0;
+    prediction_reset();
+    client_view_distance = (uint16_t)(view_distance < 1.0f ? 1.0f : view_distance > 65535.0f ? 65535.0f : view_distance);
+    client_connected = true;
+    stats_time = net_time();
+
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_NET, client_snapshots);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_NET, sent_commands);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_NET, local_entities);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_NET, local_generations);
+    client_send(NET_PACKET_HELLO, 0, 0, 0);
+    return true;
+}
+
+void net_client_close(void)
+{
+    if (sock >= 0) close(sock);
+    sock = -1;
+    client_connected = false;
+}
+
+bool net_client_active(void)
+{
+    return client_connected;
+}
+
+Entity net_client_player(void)
+{
+    return client_player;
+}
+
+void net_client_send_command(const PlayerCommand* command)
+{
+    if (!client_connected) return;
+    sent_commands[command->sequence & (NET_COMMAND_BUFFER - 1)] = *command;
+    command_newest = command->sequence;
+
+    // Everything unacknowledged goes out again, so one lost input packet costs nothing
+    uint32_t count = command_newest - command_acked;
+    if (count > NET_RESEND_COMMANDS) count = NET_RESEND_COMMANDS;
+    static uint8_t packet[sizeof(NetPacketHeader) + NET_RESEND_COMMANDS * sizeof(PlayerCommand)];
+    NetPacketHeader header = { .type = NET_PACKET_INPUT, .param = (uint16_t)count };
+    memcpy(packet, &header, sizeof(header));
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t sequence = command_newest - count + 1 + i;
+        memcpy(packet + sizeof(header) + i * sizeof(PlayerCommand), &sent_commands[sequence & (NET_COMMAND_BUFFER - 1)],
+               sizeof(PlayerCommand));
+    }
+    sendto(sock, packet, sizeof(header) + count * sizeof(PlayerCommand), 0,
+           (const struct sockaddr*)&server_address, sizeof(server_address));
+    last_sent = net_time();
+}
+
+static bool chunk_received(const ClientSnapshot* snap, uint32_t chunk)
+{
+    return (snap->received[chunk >> 3] >> (chunk & 7)) & 1u;
+}
+
+// Mirrors one decoded chunk into local entities. The player is predicted locally, its
+// server state after `command` only reconciles the prediction.
+static void client_apply(const ClientSnapshot* snap, uint32_t chunk, const RenderComponent* render,
+                         uint32_t player_slot, uint32_t command)
+{
+    uint32_t first = chunk * NET_CHUNK_ENTITIES;
+    for (Entity id = first; id < first + NET_CHUNK_ENTITIES; id++) {
+        const NetEntityState* s = &snap->states[id];
+        Entity local = local_entities[id];
+        // Gone, or the server reused the slot for a different entity
+        if (local != INVALID_ENTITY && (!s->present || local_generations[id] != s->generation)) {
+            entity_destroy(local);
+            local = INVALID_ENTITY;
+        }
+        if (!s->present) {
+            local_entities[id] = INVALID_ENTITY;
+            continue;
+        }
+        bool created = local == INVALID_ENTITY;
+        if (created) {
+            local = entity_create();
+            if (local == INVALID_ENTITY) break;
+            if (render) entity_set_render(local, *render);
+            local_generations[id] = s->generation;
+            if (s->owner && s->owner - 1u == player_slot) prediction_confirm_projectile(s->command);
+        }
+        local_entities[id] = local;
+
+        TransformComponent t = { .dirty = true };
+        for (int i = 0; i < 3; i++) {
+            t.position[i] = dequantize(s->position[i]);
+            t.scale[i] = dequantize(s->scale[i]);
+        }
+        if (id == player_slot && !created) {
+            prediction_reconcile(local, command, t.position);
+        } else {
+            quat_unpack(s->rotation, t.rotation);
+            entity_set_transform(local, t);
+        }
+
+        // Bounds from the local transform, the predicted one for the client's own player.
+        // The server never sends a body without a layer, only a corrupt snapshot would.
+        if (s->layer != 0) {
+            CollisionComponent c = {
+                .is_static = s->kind == NET_KIND_STATIC,
+                .layer = s->layer,
+                .mask = s->mask,
+            };
+            for (int i = 0; i < 3; i++) c.size[i] = dequantize(s->size[i]);
+            physics_update_collision_transform(entity_get_transform(local), &c);
+            entity_set_collision(local, c);
+        }
+
+        if (s->health != NET_NO_HEALTH) {
+            HealthComponent* h = entity_get_health(local);
+            float current = (float)s->health / 4.0f;
+            float max = h && h->max_health > current ? h->max_health : current;
+            entity_set_health(local, (HealthComponent){ .current_health = current, .max_health = max });
+        }
+    }
+}
+
+static void client_receive_snapshot(const uint8_t* data, uint32_t size, const RenderComponent* render)
+{
+    static const NetEntityState empty;
+    static NetEntityState discard[MAX_ENTITIES];
+    NetPacketHeader header;
+    if (size < sizeof(header)) return;
+    memcpy(&header, data, sizeof(header));
+    if (header.type != NET_PACKET_SNAPSHOT || header.first_chunk >= NET_CHUNKS ||
+        header.chunk_count > NET_CHUNKS - header.first_chunk) {
+        return;
+    }
+
+    if ((int32_t)(header.command - command_acked) > 0 && (int32_t)(command_newest - header.command) >= 0) {
+        command_acked = header.command;
+        prediction_acknowledge(command_acked);
+    }
+
+    ClientSnapshot* snap = &client_snapshots[history_slot(header.tick)];
+    if (snap->tick != header.tick) {
+        // Late packets of an older snapshot must not evict a newer one
+        if (!tick_newer(header.tick, snap->tick)) return;
+        snap->tick = header.tick;
+        memset(snap->received, 0, sizeof(snap->received));
+        client_snapshots_this_second++;
+    }
+
+    BitReader r = { .data = data + sizeof(header), .bit_count = (size - (uint32_t)sizeof(header)) * 8 };
+    uint32_t end = (uint32_t)header.first_chunk + header.chunk_count;
+    uint32_t age = 0;
+    bool decoded_all = true;
+    for (uint32_t chunk = header.first_chunk; chunk < end;) {
+        if (!bits_read(&r, 1)) age = read_var(&r);
+        uint32_t count = bits_read(&r, CHUNK_COUNT_BITS);
+        uint32_t chunks = count ? 1 : read_var(&r) + 1;
+        if (r.overflow || age >= NET_HISTORY || count > NET_CHUNK_ENTITIES || chunks > end - chunk) return;
+
+        // The server only deltas against chunks this client acked, but the snapshot may
+        // still have been overwritten here since
+        const ClientSnapshot* base = NULL;
+        if (age) {
+            base = &client_snapshots[history_slot(header.tick - age * NET_SNAPSHOT_INTERVAL)];
+            if (base->tick != header.tick - age * NET_SNAPSHOT_INTERVAL) base = NULL;
+        }
+
+        for (uint32_t c = chunk; c < chunk + chunks; c++) {
+            if (age && (!base || !chunk_received(base, c))) {
+                if (count && !decode_chunk(&r, discard, c, count)) return;
+                decoded_all = false;
+                continue;
+            }
+            uint32_t first = c * NET_CHUNK_ENTITIES;
+            for (uint32_t e = first; e < first + NET_CHUNK_ENTITIES; e++) {
+                snap->states[e] = base ? base->states[e] : empty;
+            }
+            if (count && !decode_chunk(&r, snap->states, c, count)) {
+                snap->received[c >> 3] &= (uint8_t)~(1u << (c & 7));
+                return;
+            }
+            snap->received[c >> 3] |= (uint8_t)(1u << (c & 7));
+
+            if (tick_newer(header.tick, chunk_applied[c])) {
+                client_apply(snap, c, render, header.param, header.command);
+                chunk_applied[c] = header.tick;
+            }
+        }
+        chunk += chunks;
+    }
+    if (header.param < MAX_ENTITIES && local_entities[header.param] != INVALID_ENTITY) {
+        client_player = local_entities[header.param];
+    }
+    if (decoded_all) client_send(NET_PACKET_ACK, header.tick, header.first_chunk, header.chunk_count);
+}
+
+void net_client_poll(const RenderComponent* render)
+{
+    if (!client_connected) return;
+    PROFILE_BEGIN("net_client_poll");
+
+    static uint8_t packet[NET_MAX_PACKET];
+    struct sockaddr_in from;
+    socklen_t from_size = sizeof(from);
+    ssize_t n;
+    while ((n = recvfrom(sock, packet, sizeof(packet), 0, (struct sockaddr*)&from, &from_size)) >= 0) {
+        from_size = sizeof(from);
+        if (!same_address(&from, &server_address)) continue;
+        client_bytes_this_second += (uint64_t)n;
+        client_receive_snapshot(packet, (uint32_t)n, render);
+    }
+
+    double now = net_time();
+    if (now - last_sent >= NET_CONNECT_INTERVAL) {
+        client_send(NET_PACKET_HELLO, 0, 0, 0);
+    }
+    if (now - stats_time >= 1.0) {
+        printf("net: received %.1f KB/s, %u snapshots/s, %u entities\n",
+               (double)client_bytes_this_second / 1024.0 / (now - stats_time), client_snapshots_this_second,
+               registry.entity_count);
+        client_bytes_this_second = 0;
+        client_snapshots_this_second = 0;
+        stats_time = now;
+    }
+    PROFILE_END("net_client_poll");
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ecs.h"
+#include "input.h"
+#include "render.h"
+
+/*
+  Snapshot replication over UDP. The server captures every physical
+  entity (transform + collision) into a quantized NetEntityState each
+  snapshot and keeps the last NET_HISTORY of them. Entity slots are
+  grouped into fixed chunks of NET_CHUNK_ENTITIES, and each chunk is
+  sent as the changes since the newest snapshot in which the client
+  acknowledged that chunk, or in full if it has none. Datagrams carry
+  whole chunks and are decoded and acked on their own, so a lost
+  datagram only costs the chunks inside it their newer baseline.
+
+  Each client only sees entities whose bounds are within its view
+  distance of its player, found through a coarse grid so the cost
+  follows what the client can see. Changed entities then compete for
+  the client's byte budget, most stale and nearest first; the rest
+  keep their previous state on the client and age until they win.
+  The server remembers per client which snapshot every held state
+  came from, so deltas stay exact against what the client really has.
+
+  Clients send PlayerCommands at the tick rate, each input packet
+  repeating every command the server has not applied yet. The server
+  applies them to the client's player before simulating, and every
+  snapshot names the newest one it applied so the client can check
+  its prediction (see prediction.h).
+
+  Positions and scales are fixed point at 1/NET_POSITION_SCALE units,
+  rotations use smallest-three quaternions in 32 bits. Packets are
+  little-endian host structs, client and server must be the same build.
+ */
+#define NET_DEFAULT_PORT       27960
+#define NET_MAX_CLIENTS        8
+#define NET_TICK_RATE          60     // Server simulation ticks per second
+#define NET_SNAPSHOT_INTERVAL  3      // Ticks between snapshots, 20 Hz
+#define NET_HISTORY            32     // Snapshots kept as delta baselines, power of two
+#define NET_MAX_PACKET         1200   // Datagram size that avoids IP fragmentation
+#define NET_CHUNK_ENTITIES     16     // Entity slots per acked unit, a full chunk always fits one datagram
+#define NET_CHUNKS             (MAX_ENTITIES / NET_CHUNK_ENTITIES)
+#define NET_MAX_VIEW_DISTANCE  64.0f  // Cap on the view distance a client asks for
+#define NET_INTEREST_CELL_SIZE 16.0f
+#define NET_PRIORITY_FALLOFF   16.0f  // Distance at which an entity's priority halves
+#define NET_CLIENT_BUDGET      (64 * 1024) // Default bytes per second of entity updates per client
+#define NET_POSITION_SCALE     256.0f
+#define NET_COMMAND_BUFFER     64     // Commands a server queues per client, power of two
+#define NET_TICK_COMMANDS      2      // Commands applied per client per tick at most, catches up after jitter
+#define NET_RESEND_COMMANDS    32     // Unacknowledged commands resent per input packet
+#define NET_CLIENT_TIMEOUT     5.0    // Seconds of silence before a client is dropped
+#define NET_CONNECT_INTERVAL   0.5    // Seconds between client hello/keepalive packets
+
+typedef enum {
+    NET_KIND_OTHER,
+    NET_KIND_STATIC,
+    NET_KIND_ZOMBIE,
+    NET_KIND_PROJECTILE,
+    NET_KIND_PLAYER,
+} NetKind;
+
+#define NET_NO_HEALTH 0xFFFFu
+
+typedef struct {
+    uint32_t generation;
+    int32_t position[3];
+    uint32_t rotation;     // Smallest-three packed
+    int32_t scale[3];
+    uint16_t health;       // Quarter points, NET_NO_HEALTH without a HealthComponent
+    uint8_t kind;          // NetKind
+    uint8_t present;
+    uint16_t owner;        // Projectiles fired by a command: shooter's slot + 1, else 0
+    uint16_t command;      // Low bits of the command that fired it
+    int32_t size[3];       // Collision size, quantized like position. The center offset is not
+                           // sent, bodies are replicated centered on their transform.
+    uint32_t layer;        // Collision PHYSICS_LAYER_* bits
+    uint32_t mask;
+} NetEntityState;
+
+// Monotonic seconds, shared by the server tick pacing and timeouts
+double net_time(void);
+void net_sleep(double seconds);
+
+// Called when a client joins, returns the entity it views the world from
+// (INVALID_ENTITY to see everything), and when it leaves or the server closes
+typedef Entity (*NetJoinCallback)(int client);
+typedef void (*NetLeaveCallback)(int client, Entity player);
+
+bool net_server_open(uint16_t port, NetJoinCallback on_join, NetLeaveCallback on_leave);
+void net_server_close(void);
+// Bytes per second of entity updates per client, removals and framing are not counted
+void net_server_set_budget(uint32_t bytes_per_second);
+// Reads client hellos and acks
+void net_server_poll(void);
+// Applies each client's queued commands to its player, call once per tick before simulating
+void net_server_apply_commands(float delta_time);
+// Captures the world as snapshot `tick` and sends every client its delta
+void net_server_send_snapshots(uint32_t tick);
+
+// `address` is "host:port" or "host", connects on NET_DEFAULT_PORT then.
+// `view_distance` is usually the camera's far plane, the server caps it.
+bool net_client_open(const char* address, float view_distance);
+void net_client_close(void);
+bool net_client_active(void);
+// Receives snapshot datagrams and applies every chunk newer than what the world
+// shows, creating replicated entities with `render` (may be NULL). The local player
+// is left to prediction and only reconciled against the server's state.
+void net_client_poll(const RenderComponent* render);
+// Sends `command` along with every earlier one the server has not applied yet
+void net_client_send_command(const PlayerCommand* command);
+// Local entity replicating this client's player on the server, INVALID_ENTITY until it arrives
+Entity net_client_player(void);
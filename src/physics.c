@@ -1,13 +1,289 @@
 #include "physics.h"
 #include "projectile.h"
+#include "profile.h"
+#include "lod.h"
+#include "spatial_hash.h"
+#include "event.h"
+#include "timer_wheel.h"
+#include "combat.h"
+#include "memory.h"
+#include <assert.h>
 #include <string.h>
 #include <stdio.h>
+#include <math.h>
 
-ECS_COMPONENT_ACCESSORS(collision, CollisionComponent, COMPONENT_COLLISION)
-ECS_COMPONENT_ACCESSORS(velocity, VelocityComponent, COMPONENT_VELOCITY)
-ECS_COMPONENT_ACCESSORS(lifetime, LifetimeComponent, COMPONENT_LIFETIME)
+typedef struct {
+    uint32_t generation;      // Entity generation this state belongs to
+    float sleep_velocity[3];  // Velocity when the body fell asleep
+    uint16_t rest_ticks;      // Ticks in a row with velocity below PHYSICS_SLEEP_SPEED
+    bool sleeping;
+    bool oversized;           // Awake this tick but too large for the dynamic grid
+} PhysicsBody;
 
-void physics_init(void) {
+// Broadphase membership of the static hash, checked every tick for changes
+typedef struct {
+    uint32_t generation;
+    bool member;
+    bool oversized;
+    // Transform the cached AABB was computed from, moving a static recomputes it
+    float position[3];
+    float rotation[4];
+    float scale[3];
+} StaticMembership;
+
+static PhysicsBody bodies[MAX_ENTITIES];
+static StaticMembership static_members[MAX_ENTITIES];
+static bool static_hash_dirty = true;
+
+// Static and sleeping bodies, rebuilt only when membership changes
+static SpatialHash static_hash;
+// Awake dynamic bodies, rebuilt every tick
+static SpatialHash dynamic_hash;
+
+// Bodies too large for the grid are tested against every awake body
+static Entity oversized[MAX_ENTITIES];
+static uint32_t oversized_count;
+static Entity dynamic_oversized[MAX_ENTITIES];
+static uint32_t dynamic_oversized_count;
+
+static Entity awake[MAX_ENTITIES];
+static uint32_t awake_count;
+
+static Entity candidates[MAX_ENTITIES];
+static Entity candidate_stamp[MAX_ENTITIES];
+
+typedef struct {
+    Entity a, b;
+    uint32_t generation_a, generation_b;
+} ContactPair;
+
+// Open-addressed set of overlapping pairs, one for last tick and one for this tick
+typedef struct {
+    ContactPair pairs[PHYSICS_MAX_CONTACTS];
+    uint32_t slot_of[PHYSICS_MAX_CONTACTS];
+    int32_t slots[PHYSICS_CONTACT_SLOTS];   // Index into pairs, -1 when empty
+    uint32_t count;
+} ContactSet;
+
+static ContactSet contact_sets[2];
+static uint32_t contact_current;
+
+// Per-query dedupe of entities spanning several cells
+static uint32_t query_stamp[MAX_ENTITIES];
+static uint32_t query_serial;
+
+// A ray's candidates in one cell, in SoA form for the slab test
+static Entity ray_entities[MAX_ENTITIES];
+static float ray_bounds[6][MAX_ENTITIES];
+static float ray_near[MAX_ENTITIES];
+
+// Lifetime expiry, so entities are only visited on the tick they die
+static double clock_seconds;
+static TimerWheel lifetime_wheel;
+static Entity expired[MAX_ENTITIES];
+
+static CollisionPair contact_enters[PHYSICS_MAX_CONTACTS];
+static uint32_t contact_enter_count;
+static CollisionPair contact_exits[PHYSICS_MAX_CONTACTS];
+static uint32_t contact_exit_count;
+
+void entity_set_collision(Entity e, CollisionComponent component)
+{
+    assert(component.layer != 0 && "collision layer not set");
+    ecs_store_collision(e, component);
+}
+
+void entity_set_velocity(Entity e, VelocityComponent component)
+{
+    ecs_store_velocity(e, component);
+    physics_wake(e);
+}
+
+static uint32_t clock_tick(void)
+{
+    return (uint32_t)(clock_seconds * PHYSICS_CLOCK_RATE);
+}
+
+void entity_set_lifetime(Entity e, LifetimeComponent component)
+{
+    component.expire_tick = clock_tick() + (uint32_t)ceil(component.lifetime * PHYSICS_CLOCK_RATE);
+    ecs_store_lifetime(e, component);
+    timer_wheel_schedule(&lifetime_wheel, e, component.expire_tick);
+}
+
+double physics_time(void)
+{
+    return clock_seconds;
+}
+
+void physics_set_time(double seconds)
+{
+    clock_seconds = seconds;
+}
+
+void physics_init(void)
+{
+    clock_seconds = 0.0;
+    physics_reset();
+
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, bodies);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, static_members);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, static_hash);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, dynamic_hash);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, oversized);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, dynamic_oversized);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, awake);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, candidates);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, candidate_stamp);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, contact_sets);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, query_stamp);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, ray_entities);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, ray_bounds);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, ray_near);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, lifetime_wheel);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, expired);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, contact_enters);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_PHYSICS, contact_exits);
+}
+
+void physics_reset(void)
+{
+    memset(bodies, 0, sizeof(bodies));
+    memset(static_members, 0, sizeof(static_members));
+    static_hash_dirty = true;
+    oversized_count = 0;
+    dynamic_oversized_count = 0;
+
+    memset(contact_sets, 0, sizeof(contact_sets));
+    for (int i = 0; i < 2; i++) {
+        memset(contact_sets[i].slots, 0xff, sizeof(contact_sets[i].slots));
+    }
+    contact_current = 0;
+
+    timer_wheel_init(&lifetime_wheel, clock_tick());
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        if (entity_is_alive(e) && (registry.component_masks[e] & COMPONENT_LIFETIME)) {
+            timer_wheel_schedule(&lifetime_wheel, e, entity_get_lifetime(e)->expire_tick);
+        }
+    }
+}
+
+static uint32_t contact_slot(Entity a, Entity b)
+{
+    return (a * 0x9E3779B1u ^ b * 0x85EBCA77u) & (PHYSICS_CONTACT_SLOTS - 1);
+}
+
+// A pair whose slot was reused since is a different contact, generations must match too
+static int32_t contact_find(const ContactSet* set, Entity a, Entity b, uint32_t generation_a, uint32_t generation_b)
+{
+    for (uint32_t slot = contact_slot(a, b);; slot = (slot + 1) & (PHYSICS_CONTACT_SLOTS - 1)) {
+        int32_t index = set->slots[slot];
+        if (index < 0) return -1;
+        const ContactPair* pair = &set->pairs[index];
+        if (pair->a == a && pair->b == b &&
+            pair->generation_a == generation_a && pair->generation_b == generation_b) {
+            return index;
+        }
+    }
+}
+
+static int32_t contact_find_live(const ContactSet* set, Entity a, Entity b)
+{
+    return contact_find(set, a, b, entity_generation(a), entity_generation(b));
+}
+
+static bool contact_insert(ContactSet* set, Entity a, Entity b)
+{
+    if (set->count >= PHYSICS_MAX_CONTACTS) return false;
+    uint32_t slot = contact_slot(a, b);
+    while (set->slots[slot] >= 0) {
+        slot = (slot + 1) & (PHYSICS_CONTACT_SLOTS - 1);
+    }
+    uint32_t index = set->count++;
+    set->pairs[index] = (ContactPair){
+        .a = a, .b = b,
+        .generation_a = entity_generation(a),
+        .generation_b = entity_generation(b)
+    };
+    set->slot_of[index] = slot;
+    set->slots[slot] = (int32_t)index;
+    return true;
+}
+
+static void contact_clear(ContactSet* set)
+{
+    for (uint32_t i = 0; i < set->count; i++) {
+        set->slots[set->slot_of[i]] = -1;
+    }
+    set->count = 0;
+}
+
+// Record an overlapping pair for this tick, a < b
+static void contact_record(Entity a, Entity b)
+{
+    ContactSet* current = &contact_sets[contact_current];
+    if (contact_find_live(current, a, b) >= 0) return;
+    if (!contact_insert(current, a, b)) return;
+    if (contact_find_live(&contact_sets[contact_current ^ 1], a, b) < 0) {
+        contact_enters[contact_enter_count++] = (CollisionPair){ a, b };
+    }
+}
+
+// Diff last tick's pairs against this tick's and queue exits
+static void contact_finish_tick(void)
+{
+    ContactSet* current = &contact_sets[contact_current];
+    const ContactSet* previous = &contact_sets[contact_current ^ 1];
+    for (uint32_t i = 0; i < previous->count; i++) {
+        const ContactPair* pair = &previous->pairs[i];
+        if (contact_find(current, pair->a, pair->b, pair->generation_a, pair->generation_b) >= 0) continue;
+
+        // Pairs of static or sleeping bodies are never retested, they stay in contact until one wakes
+        bool resting = entity_is_alive(pair->a) && entity_is_alive(pair->b) &&
+                       entity_generation(pair->a) == pair->generation_a &&
+                       entity_generation(pair->b) == pair->generation_b &&
+                       static_members[pair->a].member && static_members[pair->b].member;
+        if (resting && contact_insert(current, pair->a, pair->b)) continue;
+        contact_exits[contact_exit_count++] = (CollisionPair){ pair->a, pair->b };
+    }
+}
+
+bool physics_in_contact(Entity a, Entity b)
+{
+    if (a > b) {
+        Entity t = a;
+        a = b;
+        b = t;
+    }
+    return contact_find_live(&contact_sets[contact_current], a, b) >= 0;
+}
+
+// Body state of a reused slot starts over
+static PhysicsBody* body_of(Entity e)
+{
+    PhysicsBody* body = &bodies[e];
+    if (body->generation != entity_generation(e)) {
+        memset(body, 0, sizeof(*body));
+        body->generation = entity_generation(e);
+    }
+    return body;
+}
+
+void physics_wake(Entity e)
+{
+    if (e >= MAX_ENTITIES) return;
+    PhysicsBody* body = body_of(e);
+    if (body->sleeping) {
+        // It moves to the dynamic hash, the static one drops it on rebuild
+        static_hash_dirty = true;
+    }
+    body->sleeping = false;
+    body->rest_ticks = 0;
+}
+
+bool physics_is_sleeping(Entity e)
+{
+    return e < MAX_ENTITIES && body_of(e)->sleeping;
 }
 
 void physics_update_collision_transform(TransformComponent* transform, CollisionComponent* collision)
@@ -31,128 +307,631 @@ bool physics_check_aabb_collision(const vec3 min1, const vec3 max1, const vec3 m
            (min1[2] <= max2[2] && max1[2] >= min2[2]);
 }
 
+// Boxes that share volume, not just a face. Resolution leaves pairs exactly touching.
+static bool aabb_penetrates(const CollisionComponent* a, const CollisionComponent* b)
+{
+    return (a->min[0] < b->max[0] && a->max[0] > b->min[0]) &&
+           (a->min[1] < b->max[1] && a->max[1] > b->min[1]) &&
+           (a->min[2] < b->max[2] && a->max[2] > b->min[2]);
+}
+
+
+static bool is_dynamic_body(Entity e)
+{
+    return (registry.component_masks[e] & (COMPONENT_TRANSFORM | COMPONENT_COLLISION)) ==
+           (COMPONENT_TRANSFORM | COMPONENT_COLLISION) &&
+           !entity_get_collision_unchecked(e)->is_static;
+}
+
+static bool belongs_in_static_hash(Entity e)
+{
+    if ((registry.component_masks[e] & (COMPONENT_TRANSFORM | COMPONENT_COLLISION)) !=
+        (COMPONENT_TRANSFORM | COMPONENT_COLLISION)) {
+        return false;
+    }
+    return entity_get_collision_unchecked(e)->is_static || body_of(e)->sleeping;
+}
+
+static bool cell_span_oversized(const SpatialHash* hash, const CollisionComponent* c)
+{
+    int cells_x = spatial_hash_coord(hash, c->max[0]) - spatial_hash_coord(hash, c->min[0]) + 1;
+    int cells_z = spatial_hash_coord(hash, c->max[2]) - spatial_hash_coord(hash, c->min[2]) + 1;
+    return cells_x * cells_z > PHYSICS_MAX_CELLS_PER_BODY;
+}
+
+static bool static_moved(const StaticMembership* m, const TransformComponent* t)
+{
+    return memcmp(m->position, t->position, sizeof(m->position)) != 0 ||
+           memcmp(m->rotation, t->rotation, sizeof(m->rotation)) != 0 ||
+           memcmp(m->scale, t->scale, sizeof(m->scale)) != 0;
+}
+
+static void rebuild_static_hash(void)
+{
+    PROFILE_BEGIN("physics_rebuild_static_hash");
+    oversized_count = 0;
+    spatial_hash_begin(&static_hash, PHYSICS_CELL_SIZE);
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        StaticMembership* m = &static_members[e];
+        bool was_member = m->member;
+        m->member = entity_is_alive(e) && belongs_in_static_hash(e);
+        if (!m->member) continue;
+
+        CollisionComponent* c = entity_get_collision(e);
+        TransformComponent* t = entity_get_transform(e);
+        if (!was_member || m->generation != entity_generation(e) || static_moved(m, t)) {
+            // Statics skip the per-tick AABB update, compute it on entry and when moved
+            physics_update_collision_transform(t, c);
+            memcpy(m->position, t->position, sizeof(m->position));
+            memcpy(m->rotation, t->rotation, sizeof(m->rotation));
+            memcpy(m->scale, t->scale, sizeof(m->scale));
+        }
+        m->generation = entity_generation(e);
+        m->oversized = cell_span_oversized(&static_hash, c) ||
+                       !spatial_hash_insert_aabb(&static_hash, e, c->min, c->max);
+        if (m->oversized) {
+            oversized[oversized_count++] = e;
+        }
+    }
+    spatial_hash_end(&static_hash);
+    static_hash_dirty = false;
+    PROFILE_END("physics_rebuild_static_hash");
+}
+
+static void sync_static_membership(void)
+{
+    for (Entity e = 0; e < MAX_ENTITIES && !static_hash_dirty; e++) {
+        bool member = entity_is_alive(e) && belongs_in_static_hash(e);
+        const StaticMembership* m = &static_members[e];
+        if (member != m->member ||
+            (member && (m->generation != entity_generation(e) ||
+                        static_moved(m, entity_get_transform_unchecked(e))))) {
+            static_hash_dirty = true;
+        }
+    }
+    if (static_hash_dirty) {
+        rebuild_static_hash();
+    }
+}
+
+// Gathers unique entities from every bucket the AABB touches
+static uint32_t gather_candidates(const SpatialHash* hash, Entity self, const CollisionComponent* c, uint32_t count)
+{
+    int x0 = spatial_hash_coord(hash, c->min[0]);
+    int x1 = spatial_hash_coord(hash, c->max[0]);
+    int z0 = spatial_hash_coord(hash, c->min[2]);
+    int z1 = spatial_hash_coord(hash, c->max[2]);
+    for (int z = z0; z <= z1; z++) {
+        for (int x = x0; x <= x1; x++) {
+            uint32_t n;
+            const Entity* entries = spatial_hash_cell(hash, x, z, &n);
+            for (uint32_t i = 0; i < n; i++) {
+                Entity o = entries[i];
+                if (o == self || candidate_stamp[o] == self) continue;
+                candidate_stamp[o] = self;
+                candidates[count++] = o;
+            }
+        }
+    }
+    return count;
+}
+
+// Adds bodies kept outside the grid, skipping any already gathered
+static uint32_t append_candidates(const Entity* list, uint32_t n, Entity self, uint32_t count)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        Entity o = list[i];
+        if (o == self || candidate_stamp[o] == self) continue;
+        candidate_stamp[o] = self;
+        candidates[count++] = o;
+    }
+    return count;
+}
+
+static void physics_resolve_pair(Entity e1, Entity e2)
+{
+    CollisionComponent* c1 = entity_get_collision(e1);
+    TransformComponent* t1 = entity_get_transform(e1);
+    ProjectileComponent* p1 = entity_get_projectile(e1);
+
+    CollisionComponent* c2 = entity_get_collision(e2);
+    TransformComponent* t2 = entity_get_transform(e2);
+    ProjectileComponent* p2 = entity_get_projectile(e2);
+
+    // A projectile that already hit something this tick is on its way out
+    if ((p1 && combat_projectile_spent(e1)) || (p2 && combat_projectile_spent(e2))) return;
+    if (!physics_check_aabb_collision(c1->min, c1->max, c2->min, c2->max)) return;
+    contact_record(e1, e2);
+
+    // Projectile hits are only recorded here, combat applies damage after the tick
+    if (p1 && (!p2 || p1->owner != e2)) {
+        DamageComponent* d1 = entity_get_damage(e1);
+        combat_record_hit(e1, e2, d1 ? d1->damage_amount : 0.0f, t1->position);
+    }
+    else if (p2 && (!p1 || p2->owner != e1)) {
+        DamageComponent* d2 = entity_get_damage(e2);
+        combat_record_hit(e2, e1, d2 ? d2->damage_amount : 0.0f, t2->position);
+    }
+    // Existing collision resolution for non-projectiles
+    else {
+        vec3 penetration = {0};
+        vec3 delta;
+        vec3_sub(delta, t2->position, t1->position);
+
+        float overlap_x = fminf(c1->max[0] - c2->min[0], c2->max[0] - c1->min[0]);
+        float overlap_y = fminf(c1->max[1] - c2->min[1], c2->max[1] - c1->min[1]);
+        float overlap_z = fminf(c1->max[2] - c2->min[2], c2->max[2] - c1->min[2]);
+
+        float min_overlap = fminf(fminf(overlap_x, overlap_y), overlap_z);
+        if (min_overlap == overlap_x && overlap_x > 0) {
+            penetration[0] = (delta[0] > 0) ? overlap_x : -overlap_x;
+        } else if (min_overlap == overlap_y && overlap_y > 0) {
+            penetration[1] = (delta[1] > 0) ? overlap_y : -overlap_y;
+        } else if (min_overlap == overlap_z && overlap_z > 0) {
+            penetration[2] = (delta[2] > 0) ? overlap_z : -overlap_z;
+        }
+
+        if (c1->is_static && !c2->is_static) {
+            vec3_add(t2->position, t2->position, penetration);
+        } else if (!c1->is_static && c2->is_static) {
+            vec3 neg_penetration;
+            vec3_scale(neg_penetration, penetration, -1.0f);
+            vec3_add(t1->position, t1->position, neg_penetration);
+        } else if (!c1->is_static && !c2->is_static) {
+            vec3 half_penetration;
+            vec3_scale(half_penetration, penetration, 0.5f);
+            vec3 neg_half_penetration;
+            vec3_scale(neg_half_penetration, penetration, -0.5f);
+            vec3_add(t1->position, t1->position, neg_half_penetration);
+            vec3_add(t2->position, t2->position, half_penetration);
+        }
+
+        physics_update_collision_transform(t1, c1);
+        physics_update_collision_transform(t2, c2);
+    }
+}
+
+static void update_rest_state(Entity e)
+{
+    // Only velocity-driven bodies sleep, kinematic ones like the player stay awake
+    if ((registry.component_masks[e] & (COMPONENT_VELOCITY | COMPONENT_PROJECTILE)) != COMPONENT_VELOCITY) return;
+
+    PhysicsBody* body = body_of(e);
+    const float* v = entity_get_velocity_unchecked(e)->velocity;
+    if (v[0] * v[0] + v[1] * v[1] + v[2] * v[2] > PHYSICS_SLEEP_SPEED * PHYSICS_SLEEP_SPEED) {
+        body->rest_ticks = 0;
+        return;
+    }
+    if (++body->rest_ticks < PHYSICS_SLEEP_TICKS) return;
+
+    body->sleeping = true;
+    memcpy(body->sleep_velocity, v, sizeof(body->sleep_velocity));
+    static_hash_dirty = true;
+}
+
+static bool velocity_changed(const PhysicsBody* body, const VelocityComponent* v)
+{
+    for (int i = 0; i < 3; i++) {
+        float d = v->velocity[i] - body->sleep_velocity[i];
+        if (d > PHYSICS_WAKE_VELOCITY_DELTA || d < -PHYSICS_WAKE_VELOCITY_DELTA) return true;
+    }
+    return false;
+}
 
-// TODO: Grid partitioning collision check
 void physics_system_update(float delta_time)
 {
-    // Step 1: Update positions for entities with VelocityComponent
+    PROFILE_BEGIN("physics_system_update");
+
+    // This tick's contacts go into the older set, the other one still holds last tick's
+    contact_current ^= 1;
+    contact_clear(&contact_sets[contact_current]);
+    contact_enter_count = 0;
+    contact_exit_count = 0;
+
+    // Step 1: Update positions for awake entities with VelocityComponent
+    PROFILE_BEGIN("physics_integrate");
     for (Entity e = 0; e < MAX_ENTITIES; e++) {
         if (!entity_is_alive(e)) continue;
         if (registry.component_masks[e] & COMPONENT_VELOCITY) {
             VelocityComponent* velocity = entity_get_velocity(e);
             TransformComponent* transform = entity_get_transform(e);
-            if (velocity && transform) {
-                vec3 displacement;
-                vec3_scale(displacement, velocity->velocity, delta_time);
-                vec3_add(transform->position, transform->position, displacement);
+            if (!velocity || !transform) continue;
+
+            // Gameplay code may write velocity through the pointer, treat a change like a set
+            PhysicsBody* body = body_of(e);
+            if (body->sleeping && velocity_changed(body, velocity)) {
+                physics_wake(e);
+            }
+            if (body->sleeping) continue;
+
+            float step_dt = delta_time;
+            // LOD-scheduled entities integrate their accumulated dt when due
+            if (lod_physics_enabled() && lod_is_managed(e)) {
+                if (!lod_is_due(e)) continue;
+                step_dt = lod_elapsed(e);
             }
+            vec3 displacement;
+            vec3_scale(displacement, velocity->velocity, step_dt);
+            vec3_add(transform->position, transform->position, displacement);
         }
     }
 
-    // Step 2: Update collision transforms
+    PROFILE_END("physics_integrate");
+
+    // Step 2: Update collision transforms of awake dynamic bodies and build the broadphase
+    PROFILE_BEGIN("physics_collision_transform");
+    sync_static_membership();
+
+    awake_count = 0;
+    dynamic_oversized_count = 0;
+    spatial_hash_begin(&dynamic_hash, PHYSICS_CELL_SIZE);
     for (Entity e = 0; e < MAX_ENTITIES; e++) {
-        if (!entity_is_alive(e)) continue;
-        if ((registry.component_masks[e] & (COMPONENT_TRANSFORM | COMPONENT_COLLISION)) ==
-            (COMPONENT_TRANSFORM | COMPONENT_COLLISION)) {
-            TransformComponent* transform = entity_get_transform(e);
-            CollisionComponent* collision = entity_get_collision(e);
-            if (transform && collision) {
-                physics_update_collision_transform(transform, collision);
-            }
+        if (!entity_is_alive(e) || static_members[e].member || !is_dynamic_body(e)) continue;
+        TransformComponent* transform = entity_get_transform_unchecked(e);
+        CollisionComponent* collision = entity_get_collision_unchecked(e);
+        physics_update_collision_transform(transform, collision);
+        PhysicsBody* body = body_of(e);
+        body->oversized = cell_span_oversized(&dynamic_hash, collision) ||
+                          !spatial_hash_insert_aabb(&dynamic_hash, e, collision->min, collision->max);
+        if (body->oversized) {
+            dynamic_oversized[dynamic_oversized_count++] = e;
         }
+        awake[awake_count++] = e;
+    }
+    spatial_hash_end(&dynamic_hash);
+
+    PROFILE_END("physics_collision_transform");
+
+    // Step 3: Expire lifetimes, then handle collisions
+    PROFILE_BEGIN("physics_lifetime");
+    clock_seconds += delta_time;
+    uint32_t expired_count = timer_wheel_advance(&lifetime_wheel, clock_tick(), expired);
+    for (uint32_t i = 0; i < expired_count; i++) {
+        // A slot that was destroyed and reused keeps the old timer, skip it unless it still matches
+        Entity e = expired[i];
+        if (!entity_is_alive(e) || !(registry.component_masks[e] & COMPONENT_LIFETIME)) continue;
+        if ((int32_t)(clock_tick() - entity_get_lifetime_unchecked(e)->expire_tick) < 0) continue;
+        entity_destroy(e);
     }
+    PROFILE_END("physics_lifetime");
 
-    // Step 3: Handle lifetime and collisions
+    PROFILE_BEGIN("physics_collide");
+    memset(candidate_stamp, 0xff, sizeof(candidate_stamp));
     for (Entity e1 = 0; e1 < MAX_ENTITIES; e1++) {
         if (!entity_is_alive(e1)) continue;
 
-        // Lifetime management
-        if (registry.component_masks[e1] & COMPONENT_LIFETIME) {
-            LifetimeComponent* lifetime = entity_get_lifetime(e1);
-            if (lifetime) {
-                lifetime->lifetime -= delta_time;
-                if (lifetime->lifetime <= 0.0f) {
-                    entity_destroy(e1);
-                    continue; // Skip collision check for destroyed entities
+        // Only awake dynamic bodies look for contacts, static and sleeping pairs are never tested
+        if (static_members[e1].member || !is_dynamic_body(e1)) continue;
+        CollisionComponent* c1 = entity_get_collision_unchecked(e1);
+
+        // An oversized body checks every awake body instead of walking the many cells it covers
+        uint32_t count = body_of(e1)->oversized
+            ? append_candidates(awake, awake_count, e1, 0)
+            : gather_candidates(&dynamic_hash, e1, c1, 0);
+        count = append_candidates(dynamic_oversized, dynamic_oversized_count, e1, count);
+        count = gather_candidates(&static_hash, e1, c1, count);
+        count = append_candidates(oversized, oversized_count, e1, count);
+
+        for (uint32_t i = 0; i < count && entity_is_alive(e1); i++) {
+            Entity e2 = candidates[i];
+            if (!entity_is_alive(e2) || !(registry.component_masks[e2] & COMPONENT_COLLISION)) continue;
+            // Layer filtering rejects pairs like projectile vs projectile before any AABB test
+            CollisionComponent* c2 = entity_get_collision_unchecked(e2);
+            if (!physics_layers_collide(c1, c2)) continue;
+            if (static_members[e2].member) {
+                // Overlap wakes a sleeper, bodies resting face to face stay asleep
+                if (body_of(e2)->sleeping && aabb_penetrates(c1, c2)) {
+                    physics_wake(e2);
                 }
+                physics_resolve_pair(e1 < e2 ? e1 : e2, e1 < e2 ? e2 : e1);
+            } else if (e2 > e1) {
+                // Awake pairs are found from both sides, handle each once from the lower id
+                physics_resolve_pair(e1, e2);
             }
         }
+    }
 
-        // Collision detection
-        if (!(registry.component_masks[e1] & COMPONENT_COLLISION)) continue;
-        CollisionComponent* c1 = entity_get_collision(e1);
-        TransformComponent* t1 = entity_get_transform(e1);
-        ProjectileComponent* p1 = entity_get_projectile(e1);
-        DamageComponent* d1 = entity_get_damage(e1);
-        HealthComponent* h1 = entity_get_health(e1);
+    contact_finish_tick();
+    PROFILE_END("physics_collide");
 
-        for (Entity e2 = e1 + 1; e2 < MAX_ENTITIES; e2++) {
-            if (!entity_is_alive(e2) || !(registry.component_masks[e2] & COMPONENT_COLLISION)) continue;
-            CollisionComponent* c2 = entity_get_collision(e2);
-            TransformComponent* t2 = entity_get_transform(e2);
-            ProjectileComponent* p2 = entity_get_projectile(e2);
-            DamageComponent* d2 = entity_get_damage(e2);
-            HealthComponent* h2 = entity_get_health(e2);
-
-            if (physics_check_aabb_collision(c1->min, c1->max, c2->min, c2->max)) {
-                // Check if e1 is a projectile and e2 is not its owner
-                if (p1 && (!p2 || p1->owner != e2)) {
-                    h2->current_health -= d1->damage_amount;
-                    printf("Projectile %u hit entity %u at position (%f, %f, %f)\n",
-                           e1, e2, t1->position[0], t1->position[1], t1->position[2]);
-                    entity_destroy(e1);
-                    if (h2->current_health <= 0.0f) {
-                        entity_destroy(e2); // Destroy target if health depleted
-                    }
-                }
-                // Check if e2 is a projectile and e1 is not its owner
-                else if (p2 && (!p1 || p2->owner != e1)) {
-                    h1->current_health -= d2->damage_amount;
-                    printf("Projectile %u hit entity %u at position (%f, %f, %f)\n",
-                           e2, e1, t2->position[0], t2->position[1], t2->position[2]);
-                    entity_destroy(e2);
-                    if (h1->current_health <= 0.0f) {
-                        entity_destroy(e1); // Destroy target if health depleted
-                    }
-                }
-                // Existing collision resolution for non-projectiles
-                else {
-                    vec3 penetration = {0};
-                    vec3 delta;
-                    vec3_sub(delta, t2->position, t1->position);
-
-                    float overlap_x = fminf(c1->max[0] - c2->min[0], c2->max[0] - c1->min[0]);
-                    float overlap_y = fminf(c1->max[1] - c2->min[1], c2->max[1] - c1->min[1]);
-                    float overlap_z = fminf(c1->max[2] - c2->min[2], c2->max[2] - c1->min[2]);
-
-                    float min_overlap = fminf(fminf(overlap_x, overlap_y), overlap_z);
-                    if (min_overlap == overlap_x && overlap_x > 0) {
-                        penetration[0] = (delta[0] > 0) ? overlap_x : -overlap_x;
-                    } else if (min_overlap == overlap_y && overlap_y > 0) {
-                        penetration[1] = (delta[1] > 0) ? overlap_y : -overlap_y;
-                    } else if (min_overlap == overlap_z && overlap_z > 0) {
-                        penetration[2] = (delta[2] > 0) ? overlap_z : -overlap_z;
-                    }
-
-                    if (c1->is_static && !c2->is_static) {
-                        vec3_add(t2->position, t2->position, penetration);
-                    } else if (!c1->is_static && c2->is_static) {
-                        vec3 neg_penetration;
-                        vec3_scale(neg_penetration, penetration, -1.0f);
-                        vec3_add(t1->position, t1->position, neg_penetration);
-                    } else if (!c1->is_static && !c2->is_static) {
-                        vec3 half_penetration;
-                        vec3_scale(half_penetration, penetration, 0.5f);
-                        vec3 neg_half_penetration;
-                        vec3_scale(neg_half_penetration, penetration, -0.5f);
-                        vec3_add(t1->position, t1->position, neg_half_penetration);
-                        vec3_add(t2->position, t2->position, half_penetration);
-                    }
-
-                    physics_update_collision_transform(t1, c1);
-                    physics_update_collision_transform(t2, c2);
-                }
+    // Step 4: Track movement and put bodies that stopped moving to sleep
+    for (uint32_t i = 0; i < awake_count; i++) {
+        Entity e = awake[i];
+        if (!entity_is_alive(e) || body_of(e)->sleeping) continue;
+        update_rest_state(e);
+    }
+
+    // Resolution moved bodies after the broadphase was built, ray queries between ticks need them where they ended up
+    spatial_hash_begin(&dynamic_hash, PHYSICS_CELL_SIZE);
+    for (uint32_t i = 0; i < awake_count; i++) {
+        Entity e = awake[i];
+        if (!entity_is_alive(e) || body_of(e)->oversized) continue;
+        CollisionComponent* collision = entity_get_collision(e);
+        spatial_hash_insert_aabb(&dynamic_hash, e, collision->min, collision->max);
+    }
+    spatial_hash_end(&dynamic_hash);
+
+    // Listeners may create or destroy entities, so contacts are only sent once the tick is done
+    if (contact_enter_count > 0) {
+        event_send(EVENT_COLLISION_ENTER, &(CollisionEvent){ contact_enters, contact_enter_count });
+    }
+    if (contact_exit_count > 0) {
+        event_send(EVENT_COLLISION_EXIT, &(CollisionEvent){ contact_exits, contact_exit_count });
+    }
+
+    PROFILE_END("physics_system_update");
+}
+
+static void query_begin(void)
+{
+    if (++query_serial == 0) {
+        memset(query_stamp, 0, sizeof(query_stamp));
+        query_serial = 1;
+    }
+}
+
+// Appends unvisited entities of one bucket that the ray may hit
+static uint32_t ray_collect(const Entity* entries, uint32_t n, const PhysicsRay* ray, uint32_t count)
+{
+    const CollisionComponent* pool = ecs_get_pool(COMPONENT_COLLISION, NULL);
+    for (uint32_t i = 0; i < n; i++) {
+        Entity e = entries[i];
+        if (query_stamp[e] == query_serial) continue;
+        query_stamp[e] = query_serial;
+        // Dead entities have an empty mask
+        if (e == ray->ignore || !(registry.component_masks[e] & COMPONENT_COLLISION)) continue;
+        const CollisionComponent* c = &pool[e];
+        if (!(c->layer & ray->mask)) continue;
+
+        ray_entities[count] = e;
+        ray_bounds[0][count] = c->min[0];
+        ray_bounds[1][count] = c->min[1];
+        ray_bounds[2][count] = c->min[2];
+        ray_bounds[3][count] = c->max[0];
+        ray_bounds[4][count] = c->max[1];
+        ray_bounds[5][count] = c->max[2];
+        count++;
+    }
+    return count;
+}
+
+// Plain compares lower to minss/maxss and vectorize, fminf/fmaxf become libm calls for NaN handling
+static inline float ray_min(float a, float b) { return a < b ? a : b; }
+static inline float ray_max(float a, float b) { return a > b ? a : b; }
+
+// Entry and exit of one slab. A ray parallel to it never crosses its planes: the slab
+// spans the whole ray when the origin is between them and none of it otherwise. Both
+// sides are selects, 1/0 would give 0*inf = NaN for an origin on a plane.
+static inline void ray_slab(float lo, float hi, float origin, float inv_dir, bool parallel, float* t0, float* t1)
+{
+    bool inside = origin >= lo && origin <= hi;
+    *t0 = parallel ? (inside ? -INFINITY : INFINITY) : (lo - origin) * inv_dir;
+    *t1 = parallel ? INFINITY : (hi - origin) * inv_dir;
+}
+
+// Slab test over the collected AABBs. Branch-free over SoA arrays so the compiler
+// can vectorize it, misses come out as INFINITY.
+static void ray_slab_test(const float origin[3], const float inv_dir[3], const bool parallel[3],
+                          float max_distance, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        float tx0, tx1, ty0, ty1, tz0, tz1;
+        ray_slab(ray_bounds[0][i], ray_bounds[3][i], origin[0], inv_dir[0], parallel[0], &tx0, &tx1);
+        ray_slab(ray_bounds[1][i], ray_bounds[4][i], origin[1], inv_dir[1], parallel[1], &ty0, &ty1);
+        ray_slab(ray_bounds[2][i], ray_bounds[5][i], origin[2], inv_dir[2], parallel[2], &tz0, &tz1);
+
+        float t_near = ray_max(ray_max(ray_min(tx0, tx1), ray_min(ty0, ty1)), ray_max(ray_min(tz0, tz1), 0.0f));
+        float t_far = ray_min(ray_min(ray_max(tx0, tx1), ray_max(ty0, ty1)), ray_min(ray_max(tz0, tz1), max_distance));
+        ray_near[i] = t_near <= t_far ? t_near : INFINITY;
+    }
+}
+
+// The entry face is on the axis whose slab was entered last
+static void ray_hit_normal(const float origin[3], const float dir[3], const CollisionComponent* c, float out_normal[3])
+{
+    int axis = -1;
+    float latest = 0.0f;
+    for (int a = 0; a < 3; a++) {
+        if (fabsf(dir[a]) < PHYSICS_RAY_PARALLEL_EPSILON) continue;
+        float t_entry = ((dir[a] > 0.0f ? c->min[a] : c->max[a]) - origin[a]) / dir[a];
+        if (t_entry >= latest) {
+            latest = t_entry;
+            axis = a;
+        }
+    }
+    out_normal[0] = out_normal[1] = out_normal[2] = 0.0f;
+    if (axis < 0) {
+        // Started inside the box
+        vec3_scale(out_normal, dir, -1.0f);
+    } else {
+        out_normal[axis] = dir[axis] > 0.0f ? -1.0f : 1.0f;
+    }
+}
+
+// Walks the XZ cells the ray crosses (Amanatides-Woo), testing static and awake bodies in each
+static bool raycast_one(const PhysicsRay* ray, RaycastHit* out_hit)
+{
+    out_hit->entity = INVALID_ENTITY;
+    out_hit->distance = ray->max_distance;
+
+    float length = vec3_len(ray->direction);
+    if (length <= 0.0f || ray->max_distance <= 0.0f) return false;
+    float dir[3] = { ray->direction[0] / length, ray->direction[1] / length, ray->direction[2] / length };
+    bool parallel[3];
+    float inv_dir[3];
+    for (int a = 0; a < 3; a++) {
+        parallel[a] = fabsf(dir[a]) < PHYSICS_RAY_PARALLEL_EPSILON;
+        inv_dir[a] = parallel[a] ? 0.0f : 1.0f / dir[a];
+    }
+
+    query_begin();
+
+    // Oversized bodies are not in the grid, test them up front
+    uint32_t count = ray_collect(oversized, oversized_count, ray, 0);
+    count = ray_collect(dynamic_oversized, dynamic_oversized_count, ray, count);
+    float best = ray->max_distance;
+    Entity best_entity = INVALID_ENTITY;
+
+    const SpatialHash* hash = &dynamic_hash;
+    float cell = PHYSICS_CELL_SIZE;
+    int cx = spatial_hash_coord(hash, ray->origin[0]);
+    int cz = spatial_hash_coord(hash, ray->origin[2]);
+    int step_x = dir[0] > 0.0f ? 1 : -1;
+    int step_z = dir[2] > 0.0f ? 1 : -1;
+    float next_x = (cx + (step_x > 0)) * cell;
+    float next_z = (cz + (step_z > 0)) * cell;
+    float t_max_x = !parallel[0] ? (next_x - ray->origin[0]) * inv_dir[0] : INFINITY;
+    float t_max_z = !parallel[2] ? (next_z - ray->origin[2]) * inv_dir[2] : INFINITY;
+    float t_delta_x = !parallel[0] ? cell * fabsf(inv_dir[0]) : INFINITY;
+    float t_delta_z = !parallel[2] ? cell * fabsf(inv_dir[2]) : INFINITY;
+
+    for (int steps = 0; steps < PHYSICS_RAY_MAX_CELLS; steps++) {
+        uint32_t n;
+        const Entity* entries = spatial_hash_cell(&static_hash, cx, cz, &n);
+        count = ray_collect(entries, n, ray, count);
+        entries = spatial_hash_cell(&dynamic_hash, cx, cz, &n);
+        count = ray_collect(entries, n, ray, count);
+
+        ray_slab_test(ray->origin, inv_dir, parallel, best, count);
+        for (uint32_t i = 0; i < count; i++) {
+            if (ray_near[i] < best) {
+                best = ray_near[i];
+                best_entity = ray_entities[i];
+            }
+        }
+        count = 0;
+
+        // Anything in later cells is farther than a hit already inside this one
+        float t_exit = ray_min(t_max_x, t_max_z);
+        if (best <= t_exit || t_exit >= ray->max_distance) break;
+        if (t_max_x < t_max_z) {
+            cx += step_x;
+            t_max_x += t_delta_x;
+        } else {
+            cz += step_z;
+            t_max_z += t_delta_z;
+        }
+    }
+
+    if (best_entity == INVALID_ENTITY) return false;
+    out_hit->entity = best_entity;
+    out_hit->distance = best;
+    vec3_scale(out_hit->point, dir, best);
+    vec3_add(out_hit->point, out_hit->point, ray->origin);
+    ray_hit_normal(ray->origin, dir, entity_get_collision(best_entity), out_hit->normal);
+    return true;
+}
+
+bool physics_raycast(const PhysicsRay* ray, RaycastHit* out_hit)
+{
+    return raycast_one(ray, out_hit);
+}
+
+uint32_t physics_raycast_many(const PhysicsRay* rays, uint32_t count, RaycastHit* out_hits)
+{
+    PROFILE_BEGIN("physics_raycast_many");
+    uint32_t hits = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        hits += raycast_one(&rays[i], &out_hits[i]);
+    }
+    PROFILE_END("physics_raycast_many");
+    return hits;
+}
+
+static bool query_accepts(const PhysicsQueryFilter* filter, Entity e, const CollisionComponent* c)
+{
+    if (!filter) return true;
+    if (e == filter->ignore || !(c->layer & filter->layer_mask)) return false;
+    return (registry.component_masks[e] & filter->components) == filter->components;
+}
+
+typedef struct {
+    float min[3], max[3];
+    float center[3], radius;
+    bool sphere;
+    const PhysicsQueryFilter* filter;
+    Entity* out_entities;
+    uint32_t max_results;
+    uint32_t found;
+} OverlapQuery;
+
+static void overlap_visit(OverlapQuery* q, const Entity* entries, uint32_t n)
+{
+    const CollisionComponent* pool = ecs_get_pool(COMPONENT_COLLISION, NULL);
+    for (uint32_t i = 0; i < n && q->found < q->max_results; i++) {
+        Entity e = entries[i];
+        if (query_stamp[e] == query_serial) continue;
+        query_stamp[e] = query_serial;
+        // Dead entities have an empty mask
+        if (!(registry.component_masks[e] & COMPONENT_COLLISION)) continue;
+        const CollisionComponent* c = &pool[e];
+        if (!query_accepts(q->filter, e, c)) continue;
+
+        if (q->sphere) {
+            // Distance from the center to the closest point of the box
+            float d2 = 0.0f;
+            for (int a = 0; a < 3; a++) {
+                float v = q->center[a] < c->min[a] ? c->min[a] - q->center[a] :
+                          q->center[a] > c->max[a] ? q->center[a] - c->max[a] : 0.0f;
+                d2 += v * v;
             }
+            if (d2 > q->radius * q->radius) continue;
+        } else if (!physics_check_aabb_collision(q->min, q->max, c->min, c->max)) {
+            continue;
         }
+        q->out_entities[q->found++] = e;
     }
 }
+
+// Visits every collider in the grid cells under the query bounds once
+static uint32_t overlap_run(OverlapQuery* q)
+{
+    query_begin();
+    overlap_visit(q, oversized, oversized_count);
+    overlap_visit(q, dynamic_oversized, dynamic_oversized_count);
+
+    const SpatialHash* hashes[2] = { &static_hash, &dynamic_hash };
+    int x0 = spatial_hash_coord(&dynamic_hash, q->min[0]);
+    int x1 = spatial_hash_coord(&dynamic_hash, q->max[0]);
+    int z0 = spatial_hash_coord(&dynamic_hash, q->min[2]);
+    int z1 = spatial_hash_coord(&dynamic_hash, q->max[2]);
+    for (int h = 0; h < 2; h++) {
+        for (int z = z0; z <= z1; z++) {
+            for (int x = x0; x <= x1; x++) {
+                uint32_t n;
+                const Entity* entries = spatial_hash_cell(hashes[h], x, z, &n);
+                overlap_visit(q, entries, n);
+            }
+        }
+    }
+    return q->found;
+}
+
+uint32_t physics_overlap_sphere(const vec3 center, float radius, const PhysicsQueryFilter* filter,
+                                Entity* out_entities, uint32_t max_results)
+{
+    OverlapQuery q = {
+        .min = { center[0] - radius, center[1] - radius, center[2] - radius },
+        .max = { center[0] + radius, center[1] + radius, center[2] + radius },
+        .center = { center[0], center[1], center[2] },
+        .radius = radius,
+        .sphere = true,
+        .filter = filter,
+        .out_entities = out_entities,
+        .max_results = max_results
+    };
+    return overlap_run(&q);
+}
+
+uint32_t physics_overlap_aabb(const vec3 min, const vec3 max, const PhysicsQueryFilter* filter,
+                              Entity* out_entities, uint32_t max_results)
+{
+    OverlapQuery q = {
+        .min = { min[0], min[1], min[2] },
+        .max = { max[0], max[1], max[2] },
+        .filter = filter,
+        .out_entities = out_entities,
+        .max_results = max_results
+    };
+    return overlap_run(&q);
+}
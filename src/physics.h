@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdint.h>
 #include "ecs.h"
 #include "transform.h"
 #include "../libs/linmath/linmath.h"
@@ -10,27 +11,117 @@ typedef struct {
     vec3 size;          // Local-space full size (before scaling)
     vec3 center_offset; // Offset from transform position
     bool is_static;     // True for immovable objects (e.g., ground, walls)
+    uint32_t layer;     // PHYSICS_LAYER_* bits this body belongs to, must not be 0
+    uint32_t mask;      // PHYSICS_LAYER_* bits this body collides with
 } CollisionComponent;
 
+// Collision layers, a pair is tested only when each side's mask accepts the other's layer
+#define PHYSICS_LAYER_PLAYER      (1u << 0)
+#define PHYSICS_LAYER_ZOMBIE      (1u << 1)
+#define PHYSICS_LAYER_PROJECTILE  (1u << 2)
+#define PHYSICS_LAYER_WORLD       (1u << 3)
+#define PHYSICS_LAYER_PICKUP      (1u << 4)
+#define PHYSICS_LAYER_ALL         0xFFFFFFFFu
+
+#define PHYSICS_MASK_PLAYER      PHYSICS_LAYER_ALL
+#define PHYSICS_MASK_ZOMBIE      (PHYSICS_LAYER_PLAYER | PHYSICS_LAYER_ZOMBIE | PHYSICS_LAYER_PROJECTILE | PHYSICS_LAYER_WORLD)
+#define PHYSICS_MASK_PROJECTILE  (PHYSICS_LAYER_PLAYER | PHYSICS_LAYER_ZOMBIE | PHYSICS_LAYER_WORLD)
+#define PHYSICS_MASK_WORLD       (PHYSICS_LAYER_ALL & ~PHYSICS_LAYER_WORLD)
+#define PHYSICS_MASK_PICKUP      PHYSICS_LAYER_PLAYER
+
+static inline bool physics_layers_collide(const CollisionComponent* a, const CollisionComponent* b)
+{
+    return (a->mask & b->layer) && (b->mask & a->layer);
+}
+
 typedef struct {
     vec3 velocity;
 } VelocityComponent;
 
+// Set through entity_set_lifetime, writing lifetime through the pointer does not reschedule
 typedef struct {
-    float lifetime;
-} LifetimeComponent; 
+    float lifetime;         // Seconds to live from when it was set
+    uint32_t expire_tick;   // Physics clock tick the entity is destroyed on
+} LifetimeComponent;
+
+// Broadphase grid and sleeping
+#define PHYSICS_CELL_SIZE            4.0f
+#define PHYSICS_MAX_CELLS_PER_BODY   16     // Larger bodies skip the grid
+#define PHYSICS_SLEEP_SPEED          0.05f  // Units per second
+#define PHYSICS_SLEEP_TICKS          30     // Ticks below PHYSICS_SLEEP_SPEED before sleeping
+#define PHYSICS_WAKE_VELOCITY_DELTA  0.01f
+
+// Contact pair cache, pairs beyond the limit get no enter/exit events
+#define PHYSICS_MAX_CONTACTS         16384
+#define PHYSICS_CONTACT_SLOTS        (PHYSICS_MAX_CONTACTS * 2)  // Power of two
+
+// Lifetimes expire on a fixed-rate clock advanced by each update's delta_time
+#define PHYSICS_CLOCK_RATE  120.0   // Ticks per second
 
 void physics_init(void);
+// Drops cached state and reschedules lifetimes from the lifetime pool at the current clock
+void physics_reset(void);
+
+double physics_time(void);
+void physics_set_time(double seconds);
+
+// Sleeping bodies skip integration and broadphase updates until touched or given a new velocity
+void physics_wake(Entity e);
+bool physics_is_sleeping(Entity e);
+
+// True if the pair overlapped on the last tick. Enter and exit are sent as
+// EVENT_COLLISION_ENTER/EXIT batches at the end of physics_system_update,
+// exits may name entities that have been destroyed since.
+bool physics_in_contact(Entity a, Entity b);
 
-CollisionComponent* entity_get_collision(Entity e);
+// Asserts the body has a layer, one with none would never collide with anything
+ECS_COMPONENT_STORAGE(collision, CollisionComponent, COMPONENT_COLLISION)
 void entity_set_collision(Entity e, CollisionComponent component);
 
-VelocityComponent* entity_get_velocity(Entity e);
+// Also wakes the body
+ECS_COMPONENT_STORAGE(velocity, VelocityComponent, COMPONENT_VELOCITY)
 void entity_set_velocity(Entity e, VelocityComponent component);
 
-LifetimeComponent* entity_get_lifetime(Entity e);
+// Also schedules the expiry
+ECS_COMPONENT_STORAGE(lifetime, LifetimeComponent, COMPONENT_LIFETIME)
 void entity_set_lifetime(Entity e, LifetimeComponent component);
 
+// Ray queries against the collision world as of the last physics tick
+#define PHYSICS_RAY_MAX_CELLS        256    // Grid cells walked before a ray gives up
+#define PHYSICS_RAY_PARALLEL_EPSILON 1e-6f  // Direction components below this never cross their slab planes
+
+typedef struct {
+    vec3 origin;
+    vec3 direction;     // Need not be normalized
+    float max_distance;
+    uint32_t mask;      // PHYSICS_LAYER_* bits the ray can hit
+    Entity ignore;      // Usually the caster, INVALID_ENTITY for none
+} PhysicsRay;
+
+typedef struct {
+    Entity entity;      // INVALID_ENTITY when nothing was hit
+    float distance;
+    vec3 point;
+    vec3 normal;
+} RaycastHit;
+
+bool physics_raycast(const PhysicsRay* ray, RaycastHit* out_hit);
+// Casts count rays, out_hits[i] gets the nearest hit of rays[i]. Returns the number of rays that hit.
+uint32_t physics_raycast_many(const PhysicsRay* rays, uint32_t count, RaycastHit* out_hits);
+
+// Overlap queries, matching entities are written to out_entities without allocating.
+// Returns how many were written, at most max_results. A NULL filter accepts everything.
+typedef struct {
+    uint32_t layer_mask;        // PHYSICS_LAYER_* bits to include
+    ComponentType components;   // Components an entity must all have, 0 for any
+    Entity ignore;
+} PhysicsQueryFilter;
+
+uint32_t physics_overlap_sphere(const vec3 center, float radius, const PhysicsQueryFilter* filter,
+                                Entity* out_entities, uint32_t max_results);
+uint32_t physics_overlap_aabb(const vec3 min, const vec3 max, const PhysicsQueryFilter* filter,
+                              Entity* out_entities, uint32_t max_results);
+
 void physics_update_collision_transform(TransformComponent* transform, CollisionComponent* collision);
 bool physics_check_aabb_collision(const vec3 min1, const vec3 max1, const vec3 min2, const vec3 max2);
 void physics_system_update(float delta_time);
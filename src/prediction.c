@@ -0,0 +1,146 @@
+#include "prediction.h"
+#include "transform.h"
+#include "physics.h"
+#include "projectile.h"
+#include "memory.h"
+
+#include <math.h>
+#include <string.h>
+
+typedef struct {
+    PlayerCommand command;
+    float delta_time;
+    vec3 position;          // Player position after the command
+} PredictionFrame;
+
+typedef struct {
+    Entity entity;
+    uint32_t command;
+    float age;
+} PredictedProjectile;
+
+static PredictionFrame frames[PREDICTION_FRAMES];
+static uint32_t latest;     // Newest predicted command, 0 before the first
+
+static PredictedProjectile projectiles[PREDICTION_MAX_PROJECTILES];
+static uint32_t projectile_count;
+
+static PredictionStats stats;
+
+void prediction_reset(void)
+{
+    memset(frames, 0, sizeof(frames));
+    latest = 0;
+    projectile_count = 0;
+    memset(&stats, 0, sizeof(stats));
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_NET, frames);
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_NET, projectiles);
+}
+
+static void remove_projectile(uint32_t index)
+{
+    entity_destroy(projectiles[index].entity);
+    projectiles[index] = projectiles[--projectile_count];
+}
+
+void prediction_step(Entity player, const PlayerCommand* command, float delta_time)
+{
+    TransformComponent* t = entity_get_transform(player);
+    if (!t) return;
+
+    input_apply_command(player, command, delta_time);
+    PredictionFrame* frame = &frames[command->sequence & (PREDICTION_FRAMES - 1)];
+    frame->command = *command;
+    frame->delta_time = delta_time;
+    vec3_dup(frame->position, t->position);
+    latest = command->sequence;
+
+    ShootEvent shot;
+    if (!input_command_shot(player, command, &shot)) return;
+    // Oldest prediction makes room, its server copy is late anyway
+    if (projectile_count == PREDICTION_MAX_PROJECTILES) {
+        uint32_t oldest = 0;
+        for (uint32_t i = 1; i < projectile_count; i++) {
+            if (projectiles[i].age > projectiles[oldest].age) oldest = i;
+        }
+        remove_projectile(oldest);
+        stats.projectiles_expired++;
+    }
+    Entity e = create_projectile(player, shot.position, shot.direction, shot.command);
+    if (e == INVALID_ENTITY) return;
+    projectiles[projectile_count++] = (PredictedProjectile){ .entity = e, .command = shot.command };
+    stats.projectiles_predicted++;
+}
+
+void prediction_reconcile(Entity player, uint32_t sequence, const float position[3])
+{
+    TransformComponent* t = entity_get_transform(player);
+    const PredictionFrame* frame = &frames[sequence & (PREDICTION_FRAMES - 1)];
+    // Too old to replay from, or from before prediction started
+    if (!t || sequence == 0 || frame->command.sequence != sequence || (int32_t)(latest - sequence) < 0) return;
+
+    vec3 error;
+    vec3_sub(error, position, frame->position);
+    float distance = vec3_len(error);
+    if (distance <= PREDICTION_TOLERANCE) return;
+
+    stats.corrections++;
+    if (distance > stats.max_error) stats.max_error = distance;
+
+    // Rewind the player alone and replay what the server has not applied yet
+    for (int i = 0; i < 3; i++) t->position[i] = position[i];
+    for (uint32_t s = sequence + 1; (int32_t)(latest - s) >= 0; s++) {
+        PredictionFrame* f = &frames[s & (PREDICTION_FRAMES - 1)];
+        input_apply_command(player, &f->command, f->delta_time);
+        vec3_dup(f->position, t->position);
+        stats.replayed++;
+    }
+    t->dirty = true;
+}
+
+void prediction_confirm_projectile(uint16_t command)
+{
+    for (uint32_t i = 0; i < projectile_count; i++) {
+        if ((uint16_t)projectiles[i].command != command) continue;
+        remove_projectile(i);
+        stats.projectiles_confirmed++;
+        return;
+    }
+}
+
+void prediction_acknowledge(uint32_t sequence)
+{
+    for (uint32_t i = 0; i < projectile_count;) {
+        if ((int32_t)(sequence - projectiles[i].command) < PREDICTION_CONFIRM_COMMANDS) {
+            i++;
+            continue;
+        }
+        remove_projectile(i);
+        stats.projectiles_expired++;
+    }
+}
+
+void prediction_update_projectiles(float delta_time)
+{
+    for (uint32_t i = 0; i < projectile_count;) {
+        PredictedProjectile* p = &projectiles[i];
+        TransformComponent* t = entity_get_transform(p->entity);
+        VelocityComponent* v = entity_get_velocity(p->entity);
+        p->age += delta_time;
+        if (!t || !v || p->age > PREDICTION_PROJECTILE_TIMEOUT) {
+            remove_projectile(i);
+            stats.projectiles_expired++;
+            continue;
+        }
+        vec3 step;
+        vec3_scale(step, v->velocity, delta_time);
+        vec3_add(t->position, t->position, step);
+        t->dirty = true;
+        i++;
+    }
+}
+
+const PredictionStats* prediction_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ecs.h"
+#include "input.h"
+
+/*
+  Client-side prediction of the local player. Every command is applied
+  locally as soon as it is made and kept with the position it produced.
+  When a snapshot reports where the server had the player after some
+  command, a mismatch rewinds just the player to the server position
+  and replays the newer commands; the rest of the world is never
+  re-simulated. Shots spawn a predicted projectile at once, which is
+  retired when the server's projectile for the same command arrives.
+  A shot whose command the server applied a few snapshots ago without
+  one showing up hit something right away and is retired as well;
+  PREDICTION_PROJECTILE_TIMEOUT covers the rest.
+ */
+#define PREDICTION_FRAMES             256    // Commands kept for replay, power of two
+#define PREDICTION_TOLERANCE          0.01f  // Units of disagreement ignored, above position quantization
+#define PREDICTION_MAX_PROJECTILES    64
+#define PREDICTION_PROJECTILE_TIMEOUT 1.0f   // Seconds a predicted shot waits for the server's
+#define PREDICTION_CONFIRM_COMMANDS   8      // Commands past a shot's the server applies before giving up on it
+
+typedef struct {
+    uint32_t corrections;
+    uint32_t replayed;              // Commands re-applied by corrections
+    float max_error;
+    uint32_t projectiles_predicted;
+    uint32_t projectiles_confirmed;
+    uint32_t projectiles_expired;
+} PredictionStats;
+
+void prediction_reset(void);
+
+// Applies `command` to the local player, records the result and fires a predicted projectile
+void prediction_step(Entity player, const PlayerCommand* command, float delta_time);
+
+// Server position of the player after command `sequence`, replays newer commands on a mismatch
+void prediction_reconcile(Entity player, uint32_t sequence, const float position[3]);
+
+// The server's projectile for the command with these low 16 bits arrived
+void prediction_confirm_projectile(uint16_t command);
+// The server applied every command up to `sequence`
+void prediction_acknowledge(uint32_t sequence);
+
+// Moves predicted projectiles and drops the ones the server never confirmed
+void prediction_update_projectiles(float delta_time);
+
+const PredictionStats* prediction_stats(void);
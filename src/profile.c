@@ -0,0 +1,158 @@
+#define _POSIX_C_SOURCE 200809L
+#include "profile.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+
+typedef enum {
+    PROFILE_PHASE_BEGIN,
+    PROFILE_PHASE_END,
+} ProfilePhase;
+
+// 16 bytes per marker, names and threads are stored as small indices
+typedef struct {
+    uint64_t timestamp_ns;
+    uint32_t frame;
+    uint16_t name_id;
+    uint8_t  phase;
+    uint8_t  thread_id;
+} ProfileEvent;
+
+static ProfileEvent profile_events[PROFILE_MAX_EVENTS];
+static atomic_uint_fast64_t profile_write_index;
+
+static const char* profile_names[PROFILE_MAX_NAMES];
+static atomic_int profile_name_count;
+
+static const char* profile_thread_names[PROFILE_MAX_THREADS];
+static atomic_int profile_thread_count;
+static _Thread_local int profile_thread_id = -1;
+
+static uint64_t profile_start_ns;
+static atomic_uint profile_frame;
+
+static uint64_t profile_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int profile_current_thread(void)
+{
+    if (profile_thread_id < 0) {
+        int id = atomic_fetch_add(&profile_thread_count, 1);
+        // Threads past the limit share the last track rather than dropping markers
+        profile_thread_id = id < PROFILE_MAX_THREADS ? id : PROFILE_MAX_THREADS - 1;
+    }
+    return profile_thread_id;
+}
+
+static uint16_t profile_intern(const char* name)
+{
+    int count = atomic_load(&profile_name_count);
+    for (int i = 0; i < count; i++) {
+        if (profile_names[i] == name) return (uint16_t)i;
+    }
+    // Slow path: names are registered rarely, a racing duplicate entry is harmless
+    int id = atomic_fetch_add(&profile_name_count, 1);
+    if (id >= PROFILE_MAX_NAMES) {
+        atomic_store(&profile_name_count, PROFILE_MAX_NAMES);
+        return PROFILE_MAX_NAMES - 1;
+    }
+    profile_names[id] = name;
+    return (uint16_t)id;
+}
+
+static void profile_record(const char* name, ProfilePhase phase)
+{
+    uint64_t index = atomic_fetch_add_explicit(&profile_write_index, 1, memory_order_relaxed);
+    ProfileEvent* ev = &profile_events[index & (PROFILE_MAX_EVENTS - 1)];
+    ev->timestamp_ns = profile_now_ns();
+    ev->frame = atomic_load_explicit(&profile_frame, memory_order_relaxed);
+    ev->name_id = profile_intern(name);
+    ev->phase = (uint8_t)phase;
+    ev->thread_id = (uint8_t)profile_current_thread();
+}
+
+void profile_init(void)
+{
+    memset(profile_events, 0, sizeof(profile_events));
+    memset(profile_names, 0, sizeof(profile_names));
+    atomic_store(&profile_write_index, 0);
+    atomic_store(&profile_name_count, 0);
+    atomic_store(&profile_frame, 0);
+    profile_start_ns = profile_now_ns();
+    profile_set_thread_name("main");
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_DEBUG, profile_events);
+}
+
+void profile_set_thread_name(const char* name)
+{
+    profile_thread_names[profile_current_thread()] = name;
+}
+
+void profile_frame_mark(void)
+{
+    atomic_fetch_add_explicit(&profile_frame, 1, memory_order_relaxed);
+}
+
+void profile_begin(const char* name)
+{
+    profile_record(name, PROFILE_PHASE_BEGIN);
+}
+
+void profile_end(const char* name)
+{
+    profile_record(name, PROFILE_PHASE_END);
+}
+
+bool profile_export_trace(const char* path)
+{
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "profile: failed to open %s\n", path);
+        return false;
+    }
+
+    uint64_t end = atomic_load(&profile_write_index);
+    uint64_t start = end > PROFILE_MAX_EVENTS ? end - PROFILE_MAX_EVENTS : 0;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+
+    int thread_count = atomic_load(&profile_thread_count);
+    if (thread_count > PROFILE_MAX_THREADS) thread_count = PROFILE_MAX_THREADS;
+    for (int t = 0; t < thread_count; t++) {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", t, profile_thread_names[t] ? profile_thread_names[t] : "worker");
+        first = false;
+    }
+
+    // The ring may have dropped the begin of a scope, skip ends that have no open begin
+    int depth[PROFILE_MAX_THREADS] = {0};
+    for (uint64_t i = start; i < end; i++) {
+        const ProfileEvent* ev = &profile_events[i & (PROFILE_MAX_EVENTS - 1)];
+        if (ev->phase == PROFILE_PHASE_END) {
+            if (depth[ev->thread_id] == 0) continue;
+            depth[ev->thread_id]--;
+        } else {
+            depth[ev->thread_id]++;
+        }
+
+        const char* name = profile_names[ev->name_id] ? profile_names[ev->name_id] : "?";
+        double ts_us = (double)(ev->timestamp_ns - profile_start_ns) / 1000.0;
+        fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"frame\":%u}}",
+                first ? "" : ",\n", name, ev->phase == PROFILE_PHASE_BEGIN ? 'B' : 'E',
+                ts_us, ev->thread_id, ev->frame);
+        first = false;
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    printf("profile: wrote %llu events to %s\n", (unsigned long long)(end - start), path);
+    return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PROFILE_MAX_EVENTS  (1 << 18) // Ring capacity, oldest events are overwritten
+#define PROFILE_MAX_NAMES   128
+#define PROFILE_MAX_THREADS 16
+
+/*
+  Trace markers. Names must be string literals (or otherwise outlive the
+  profiler), they are interned by pointer and resolved at export time.
+  Build with -DPROFILE_DISABLED to compile every marker out.
+ */
+#ifndef PROFILE_DISABLED
+#define PROFILE_BEGIN(name) profile_begin(name)
+#define PROFILE_END(name)   profile_end(name)
+#else
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END(name)   ((void)0)
+#endif
+
+void profile_init(void);
+void profile_set_thread_name(const char* name);
+void profile_frame_mark(void);
+
+void profile_begin(const char* name);
+void profile_end(const char* name);
+
+// Writes the recorded markers as Chrome Trace Event JSON (Perfetto, chrome://tracing)
+bool profile_export_trace(const char* path);
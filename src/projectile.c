@@ -6,22 +6,59 @@
 #include "macros.h"
 #include "event.h"
 
-ECS_COMPONENT_ACCESSORS(projectile, ProjectileComponent, COMPONENT_PROJECTILE)
-
 static void on_shoot(void* data)
 {
     ShootEvent* ev = (ShootEvent*)data;
-    create_projectile(ev->shooter, ev->position, ev->direction);
+    create_projectile(ev->shooter, ev->position, ev->direction, ev->command);
 }
 
+// Every projectile draws this one mesh. Projectiles can be fired from a worker
+// thread, which must not create GPU resources, so it is made up front.
+static RenderComponent projectile_rc;
+static bool mesh_created = false;
+
 void projectile_init(void)
 {
     event_register(EVENT_SHOOT, on_shoot); // pass func ptr for on_shoot
+
+    static float vertices[] = {
+        -1, -1,  1,   1,0,0,1,
+         1, -1,  1,   0,1,0,1,
+         1,  1,  1,   0,0,1,1,
+        -1,  1,  1,   1,1,0,1,
+        -1, -1, -1,   1,0,1,1,
+         1, -1, -1,   0,1,1,1,
+         1,  1, -1,   0.5f,0.5f,0.5f,1,
+        -1,  1, -1,   0,0,0,1
+    };
+    static uint16_t indices[] = {
+        0,1,2,  0,2,3,
+        1,5,6,  1,6,2,
+        5,4,7,  5,7,6,
+        4,0,3,  4,3,7,
+        4,5,1,  4,1,0,
+        3,2,6,  3,6,7
+    };
+    if (!mesh_created) {
+        projectile_rc = create_render_component(
+            vertices, sizeof(vertices),
+            indices, sizeof(indices) / sizeof(indices[0])
+        );
+        mesh_created = true;
+    }
 }
 
-void create_projectile(Entity shooter, vec3 position, vec3 direction) {
+void projectile_shutdown(void)
+{
+    if (mesh_created) {
+        destroy_render_component(&projectile_rc);
+        mesh_created = false;
+    }
+}
+
+Entity create_projectile(Entity shooter, vec3 position, vec3 direction, uint32_t command) {
     Entity projectile = entity_create();
-    if (projectile == INVALID_ENTITY) return;
+    if (projectile == INVALID_ENTITY) return INVALID_ENTITY;
 
     // Offset projectile from shooter position along direction
     vec3 offset;
@@ -44,38 +81,18 @@ void create_projectile(Entity shooter, vec3 position, vec3 direction) {
     VelocityComponent v = { .velocity = {velocity[0], velocity[1], velocity[2]} };
     entity_set_velocity(projectile, v);
 
-    static float vertices[] = {
-        -1, -1,  1,   1,0,0,1,
-         1, -1,  1,   0,1,0,1,
-         1,  1,  1,   0,0,1,1,
-        -1,  1,  1,   1,1,0,1,
-        -1, -1, -1,   1,0,1,1,
-         1, -1, -1,   0,1,1,1,
-         1,  1, -1,   0.5f,0.5f,0.5f,1,
-        -1,  1, -1,   0,0,0,1
-    };
-    static uint16_t indices[] = {
-        0,1,2,  0,2,3,
-        1,5,6,  1,6,2,
-        5,4,7,  5,7,6,
-        4,0,3,  4,3,7,
-        4,5,1,  4,1,0,
-        3,2,6,  3,6,7
-    };
-    RenderComponent rc = create_render_component(
-        vertices, sizeof(vertices),
-        indices, sizeof(indices) / sizeof(indices[0])
-    );
-    entity_set_render(projectile, rc);
+    entity_set_render(projectile, projectile_rc);
 
     CollisionComponent c = {
         .size = {1.0f, 1.0f, 1.0f},
         .center_offset = {0, 0, 0},
-        .is_static = false
+        .is_static = false,
+        .layer = PHYSICS_LAYER_PROJECTILE,
+        .mask = PHYSICS_MASK_PROJECTILE
     };
     entity_set_collision(projectile, c);
 
-    ProjectileComponent p = { .owner = shooter };
+    ProjectileComponent p = { .owner = shooter, .command = command };
     entity_set_projectile(projectile, p);
 
     DamageComponent d = { .damage_amount = 10.0f };
@@ -83,4 +100,5 @@ void create_projectile(Entity shooter, vec3 position, vec3 direction) {
 
     LifetimeComponent l = { .lifetime = 5.0f };
     entity_set_lifetime(projectile, l);
+    return projectile;
 }
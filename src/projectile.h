@@ -4,9 +4,11 @@
 
 typedef struct {
     Entity owner;
+    uint32_t command;   // PlayerCommand sequence that fired it, 0 outside networked play
 } ProjectileComponent;
 
 void projectile_init(void);
-void create_projectile(Entity shooter, vec3 position, vec3 direction);
-ProjectileComponent* entity_get_projectile(Entity e);
-void entity_set_projectile(Entity e, ProjectileComponent component);
+// Frees the shared projectile mesh, after the last frame is drawn
+void projectile_shutdown(void);
+Entity create_projectile(Entity shooter, vec3 position, vec3 direction, uint32_t command);
+ECS_COMPONENT_DECLARE(projectile, ProjectileComponent, COMPONENT_PROJECTILE)
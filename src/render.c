@@ -1,20 +1,30 @@
 #include "render.h"
+#include "memory.h"
 #include "../libs/sokol/HandmadeMath.h"
 #include "cube.glsl.h"
 
 #include <stddef.h>
-
-ECS_COMPONENT_ACCESSORS(render, RenderComponent, COMPONENT_RENDER)
+#include <string.h>
 
 sg_shader cube_shader = {0};
 sg_pipeline cube_pipeline = {0};
 bool render_initialized = false;
+static bool render_headless = false;
+
+void render_set_headless(bool headless)
+{
+    render_headless = headless;
+}
 
 RenderComponent create_render_component(
     const float* vertices, size_t vertex_size,
     const uint16_t* indices, size_t index_count
 )
 {
+    if (render_headless) {
+        return (RenderComponent){ .index_count = index_count };
+    }
+
     if (!render_initialized) {
         cube_shader = sg_make_shader(cube_shader_desc(sg_query_backend()));
         cube_pipeline = sg_make_pipeline(&(sg_pipeline_desc){
@@ -46,6 +56,163 @@ RenderComponent create_render_component(
     });
     rc.index_count = index_count;
     rc.pipeline = cube_pipeline;
+    memory_track_buffer(MEMORY_TAG_RENDER, rc.vertex_buffer.id, vertex_size, "vertices");
+    memory_track_buffer(MEMORY_TAG_RENDER, rc.index_buffer.id, index_count * sizeof(uint16_t), "indices");
 
     return rc;
 }
+
+void destroy_render_component(RenderComponent* rc)
+{
+    if (!render_headless) {
+        memory_release_buffer(rc->vertex_buffer.id);
+        memory_release_buffer(rc->index_buffer.id);
+        sg_destroy_buffer(rc->vertex_buffer);
+        sg_destroy_buffer(rc->index_buffer);
+    }
+    *rc = (RenderComponent){0};
+}
+
+typedef struct {
+    uint64_t key;
+    uint32_t item;
+} SortEntry;
+
+typedef struct {
+    DrawItem items[RENDER_QUEUE_MAX];
+    SortEntry entries[2][RENDER_QUEUE_MAX]; // Radix sort ping-pongs between the two
+    const SortEntry* sorted;
+    uint32_t count;
+    uint32_t dropped;
+} RenderPacket;
+
+static RenderPacket packets[2];
+static RenderPacket* back_packet = &packets[0];
+static RenderPacket* front_packet = &packets[1];
+static RenderStats stats;
+
+uint64_t render_sort_key(RenderPass pass, sg_pipeline pipeline, uint32_t material, sg_buffer mesh, float depth)
+{
+    const uint32_t depth_max = (1u << RENDER_DEPTH_BITS) - 1;
+    if (!(depth > 0.0f)) depth = 0.0f;
+    if (depth > 1.0f) depth = 1.0f;
+    uint64_t d = (uint64_t)(depth * (float)depth_max);
+    uint64_t p = pipeline.id & 0xFFF;
+    uint64_t m = material & 0xFFF;
+    uint64_t b = mesh.id & 0xFFFF;
+
+    if (pass == RENDER_PASS_OPAQUE) {
+        return ((uint64_t)pass << 60) | (p << 48) | (m << 36) | (b << 20) | d;
+    }
+    return ((uint64_t)pass << 60) | ((depth_max - d) << 40) | (p << 28) | (m << 16) | b;
+}
+
+void render_queue_init(void)
+{
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_RENDER, packets);
+}
+
+void render_queue_begin(void)
+{
+    back_packet->count = 0;
+    back_packet->dropped = 0;
+    back_packet->sorted = back_packet->entries[0];
+}
+
+void render_queue_push(uint64_t key, const DrawItem* item)
+{
+    RenderPacket* packet = back_packet;
+    if (packet->count == RENDER_QUEUE_MAX) {
+        packet->dropped++;
+        return;
+    }
+    packet->items[packet->count] = *item;
+    packet->entries[0][packet->count] = (SortEntry){ .key = key, .item = packet->count };
+    packet->count++;
+}
+
+// LSD radix sort on the key a byte at a time, stable so equal keys keep push order.
+// Bytes every key shares are skipped, which is most of them with few pipelines and meshes.
+void render_queue_end(void)
+{
+    RenderPacket* packet = back_packet;
+    SortEntry* src = packet->entries[0];
+    SortEntry* dst = packet->entries[1];
+    uint64_t all_or = 0, all_and = ~(uint64_t)0;
+    for (uint32_t i = 0; i < packet->count; i++) {
+        all_or |= src[i].key;
+        all_and &= src[i].key;
+    }
+    uint64_t varying = all_or ^ all_and;
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        if (((varying >> shift) & 0xFF) == 0) continue;
+
+        uint32_t offsets[256] = {0};
+        for (uint32_t i = 0; i < packet->count; i++) {
+            offsets[(src[i].key >> shift) & 0xFF]++;
+        }
+        uint32_t sum = 0;
+        for (int b = 0; b < 256; b++) {
+            uint32_t n = offsets[b];
+            offsets[b] = sum;
+            sum += n;
+        }
+        for (uint32_t i = 0; i < packet->count; i++) {
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+        SortEntry* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    packet->sorted = src;
+}
+
+void render_queue_swap(void)
+{
+    RenderPacket* tmp = front_packet;
+    front_packet = back_packet;
+    back_packet = tmp;
+}
+
+void render_queue_submit(void)
+{
+    const RenderPacket* packet = front_packet;
+    memset(&stats, 0, sizeof(stats));
+    stats.dropped = packet->dropped;
+
+    sg_pipeline pipeline = {0};
+    sg_buffer vertex_buffer = {0};
+    sg_buffer index_buffer = {0};
+
+    for (uint32_t i = 0; i < packet->count; i++) {
+        const DrawItem* item = &packet->items[packet->sorted[i].item];
+        bool pipeline_changed = item->pipeline.id != pipeline.id;
+        if (pipeline_changed) {
+            sg_apply_pipeline(item->pipeline);
+            pipeline = item->pipeline;
+            stats.pipeline_changes++;
+        }
+        // Applying a pipeline clears the bound resources, so rebind after one
+        if (pipeline_changed || item->vertex_buffer.id != vertex_buffer.id ||
+            item->index_buffer.id != index_buffer.id)
+        {
+            sg_bindings bind = {
+                .vertex_buffers[0] = item->vertex_buffer,
+                .index_buffer      = item->index_buffer
+            };
+            sg_apply_bindings(&bind);
+            vertex_buffer = item->vertex_buffer;
+            index_buffer = item->index_buffer;
+            stats.binding_changes++;
+        }
+        sg_apply_uniforms(0, &SG_RANGE(item->mvp));
+        sg_draw(0, item->index_count, 1);
+        stats.draws++;
+    }
+}
+
+const RenderStats* render_stats(void)
+{
+    return &stats;
+}
@@ -14,7 +14,76 @@ typedef struct {
 extern sg_shader cube_shader;
 extern sg_pipeline cube_pipeline;
 
-RenderComponent* entity_get_render(Entity e);
-void entity_set_render(Entity e, RenderComponent component);
+ECS_COMPONENT_DECLARE(render, RenderComponent, COMPONENT_RENDER)
+
+// Headless runs (replays, servers) have no sokol_gfx context, meshes become empty handles
+void render_set_headless(bool headless);
 
 RenderComponent create_render_component(const float* vertices, size_t vertex_size, const uint16_t* indices, size_t index_count);
+// Frees the mesh buffers, the pipeline is shared and stays. Entities still drawing `rc` must be gone.
+void destroy_render_component(RenderComponent* rc);
+
+/*
+  Draws are not issued while walking the world. Each one is pushed into
+  a render packet with a 64-bit sort key, the packet is radix sorted
+  and submitted in key order, and submission only applies a pipeline or
+  bindings when they differ from the previous draw's.
+
+  Opaque keys:      pass:4 | pipeline:12 | material:12 | mesh:16 | depth:20
+  Transparent keys: pass:4 | ~depth:20   | pipeline:12 | material:12 | mesh:16
+
+  Opaque draws group by state and go front to back inside a group so
+  early depth rejection still helps. Transparent draws must blend back
+  to front, so depth leads and state only breaks ties. Pipeline and mesh
+  fields hold the low bits of the handle ids, which only order the
+  queue; submission compares the full handles.
+
+  There are two packets. The simulation side fills and sorts the back
+  one (render_queue_begin/push/end) while the GPU side submits the front
+  one, and render_queue_swap flips them while neither is running. A
+  packet holds finished MVPs and handles only, nothing in it points back
+  into the ECS.
+ */
+#define RENDER_QUEUE_MAX   MAX_ENTITIES
+#define RENDER_DEPTH_BITS  20
+
+typedef enum {
+    RENDER_PASS_OPAQUE,
+    RENDER_PASS_TRANSPARENT,
+    RENDER_PASS_UI,
+} RenderPass;
+
+typedef struct {
+    sg_pipeline pipeline;
+    sg_buffer vertex_buffer;
+    sg_buffer index_buffer;
+    int index_count;
+    mat4x4 mvp;
+} DrawItem;
+
+typedef struct {
+    uint32_t draws;
+    uint32_t pipeline_changes;
+    uint32_t binding_changes;
+    uint32_t dropped;           // Pushes past RENDER_QUEUE_MAX
+} RenderStats;
+
+// `depth` is view distance over the far plane, clamped to [0, 1]. Material is 0 until
+// RenderComponent carries one.
+uint64_t render_sort_key(RenderPass pass, sg_pipeline pipeline, uint32_t material, sg_buffer mesh, float depth);
+
+void render_queue_init(void);
+// Producer side, fills the back packet
+void render_queue_begin(void);
+void render_queue_push(uint64_t key, const DrawItem* item);
+void render_queue_end(void);
+
+// Makes the last finished back packet the one submitted, the old front is refilled next
+void render_queue_swap(void);
+
+// Issues the front packet's draws, must run inside a pass on the GPU thread.
+// A packet can be submitted more than once, until the next swap.
+void render_queue_submit(void);
+
+// Counters of the last submitted frame
+const RenderStats* render_stats(void);
@@ -0,0 +1,119 @@
+#include "replay.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define REPLAY_KEY_COUNT (sizeof(((InputState*)0)->keys) / sizeof(bool))
+
+typedef struct {
+    FILE* file;
+    ReplayHeader header;
+    bool keys[REPLAY_KEY_COUNT]; // Key state as of the last recorded/replayed tick
+} ReplayStream;
+
+static ReplayStream recorder;
+static ReplayStream player;
+
+bool replay_record_begin(const char* path)
+{
+    memset(&recorder, 0, sizeof(recorder));
+    recorder.file = fopen(path, "wb");
+    if (!recorder.file) {
+        fprintf(stderr, "replay: failed to open %s for writing\n", path);
+        return false;
+    }
+    recorder.header = (ReplayHeader){ .magic = REPLAY_MAGIC, .version = REPLAY_VERSION, .tick_count = 0 };
+    fwrite(&recorder.header, sizeof(recorder.header), 1, recorder.file);
+    return true;
+}
+
+bool replay_is_recording(void)
+{
+    return recorder.file != NULL;
+}
+
+void replay_record_tick(const InputState* input, float delta_time)
+{
+    if (!recorder.file) return;
+
+    uint16_t changed[REPLAY_KEY_COUNT];
+    uint16_t changed_count = 0;
+    for (uint16_t k = 0; k < REPLAY_KEY_COUNT; k++) {
+        if (input->keys[k] != recorder.keys[k]) {
+            changed[changed_count++] = k;
+            recorder.keys[k] = input->keys[k];
+        }
+    }
+
+    float values[3] = { delta_time, input->mouse_dx, input->mouse_dy };
+    fwrite(values, sizeof(values), 1, recorder.file);
+    fwrite(&changed_count, sizeof(changed_count), 1, recorder.file);
+    fwrite(changed, sizeof(uint16_t), changed_count, recorder.file);
+    recorder.header.tick_count++;
+}
+
+void replay_record_end(void)
+{
+    if (!recorder.file) return;
+
+    // Patch the final tick count into the header
+    fseek(recorder.file, 0, SEEK_SET);
+    fwrite(&recorder.header, sizeof(recorder.header), 1, recorder.file);
+    fclose(recorder.file);
+    printf("replay: recorded %u ticks\n", recorder.header.tick_count);
+    recorder.file = NULL;
+}
+
+bool replay_open(const char* path)
+{
+    memset(&player, 0, sizeof(player));
+    player.file = fopen(path, "rb");
+    if (!player.file) {
+        fprintf(stderr, "replay: failed to open %s\n", path);
+        return false;
+    }
+    if (fread(&player.header, sizeof(player.header), 1, player.file) != 1 ||
+        player.header.magic != REPLAY_MAGIC || player.header.version != REPLAY_VERSION) {
+        fprintf(stderr, "replay: %s is not a version %d replay\n", path, REPLAY_VERSION);
+        replay_close();
+        return false;
+    }
+    return true;
+}
+
+uint32_t replay_tick_count(void)
+{
+    return player.header.tick_count;
+}
+
+bool replay_next_tick(InputState* input, float* delta_time)
+{
+    if (!player.file) return false;
+
+    float values[3];
+    uint16_t changed_count;
+    if (fread(values, sizeof(values), 1, player.file) != 1 ||
+        fread(&changed_count, sizeof(changed_count), 1, player.file) != 1 ||
+        changed_count > REPLAY_KEY_COUNT) {
+        return false;
+    }
+
+    uint16_t changed[REPLAY_KEY_COUNT];
+    if (fread(changed, sizeof(uint16_t), changed_count, player.file) != changed_count) return false;
+    for (uint16_t i = 0; i < changed_count; i++) {
+        if (changed[i] < REPLAY_KEY_COUNT) player.keys[changed[i]] = !player.keys[changed[i]];
+    }
+
+    // input_process consumes state (mouse deltas, debounced keys), so overwrite it every tick
+    memcpy(input->keys, player.keys, sizeof(player.keys));
+    input->mouse_dx = values[1];
+    input->mouse_dy = values[2];
+    *delta_time = values[0];
+    return true;
+}
+
+void replay_close(void)
+{
+    if (player.file) fclose(player.file);
+    player.file = NULL;
+}
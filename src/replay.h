@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "input.h"
+
+#define REPLAY_MAGIC   0x5045525au // "ZREP"
+#define REPLAY_VERSION 1
+
+/*
+  Per-tick input stream. Each tick stores dt, the accumulated mouse delta
+  and the key codes whose state toggled since the previous tick, which is
+  all input_process reads from InputState.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t tick_count;
+} ReplayHeader;
+
+bool replay_record_begin(const char* path);
+void replay_record_tick(const InputState* input, float delta_time);
+void replay_record_end(void);
+bool replay_is_recording(void);
+
+bool replay_open(const char* path);
+bool replay_next_tick(InputState* input, float* delta_time);
+uint32_t replay_tick_count(void);
+void replay_close(void);
@@ -0,0 +1,315 @@
+#include "simd_math.h"
+#include "memory.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !defined(SIMD_MATH_DISABLED) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define SIMD_MATH_BACKEND "sse2"
+typedef __m128 v4;
+static inline v4 v4_load(const float* p) { return _mm_loadu_ps(p); }
+static inline void v4_store(float* p, v4 v) { _mm_storeu_ps(p, v); }
+static inline v4 v4_splat(float x) { return _mm_set1_ps(x); }
+static inline v4 v4_set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+static inline v4 v4_add(v4 a, v4 b) { return _mm_add_ps(a, b); }
+static inline v4 v4_sub(v4 a, v4 b) { return _mm_sub_ps(a, b); }
+static inline v4 v4_mul(v4 a, v4 b) { return _mm_mul_ps(a, b); }
+#elif !defined(SIMD_MATH_DISABLED) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_MATH_BACKEND "neon"
+typedef float32x4_t v4;
+static inline v4 v4_load(const float* p) { return vld1q_f32(p); }
+static inline void v4_store(float* p, v4 v) { vst1q_f32(p, v); }
+static inline v4 v4_splat(float x) { return vdupq_n_f32(x); }
+static inline v4 v4_set(float a, float b, float c, float d) { return (v4){ a, b, c, d }; }
+static inline v4 v4_add(v4 a, v4 b) { return vaddq_f32(a, b); }
+static inline v4 v4_sub(v4 a, v4 b) { return vsubq_f32(a, b); }
+// Separate multiply and add, a fused vfmaq would round differently from linmath
+static inline v4 v4_mul(v4 a, v4 b) { return vmulq_f32(a, b); }
+#else
+#define SIMD_MATH_BACKEND "scalar"
+typedef struct { float f[4]; } v4;
+static inline v4 v4_load(const float* p) { v4 r; memcpy(r.f, p, sizeof(r.f)); return r; }
+static inline void v4_store(float* p, v4 v) { memcpy(p, v.f, sizeof(v.f)); }
+static inline v4 v4_splat(float x) { return (v4){{ x, x, x, x }}; }
+static inline v4 v4_set(float a, float b, float c, float d) { return (v4){{ a, b, c, d }}; }
+static inline v4 v4_add(v4 a, v4 b) { for (int i = 0; i < 4; i++) a.f[i] += b.f[i]; return a; }
+static inline v4 v4_sub(v4 a, v4 b) { for (int i = 0; i < 4; i++) a.f[i] -= b.f[i]; return a; }
+static inline v4 v4_mul(v4 a, v4 b) { for (int i = 0; i < 4; i++) a.f[i] *= b.f[i]; return a; }
+#endif
+
+const char* simd_math_backend(void)
+{
+    return SIMD_MATH_BACKEND;
+}
+
+// Column `c` of a * b given a's columns, summed in linmath's k order
+static inline v4 combine(const v4 a[4], float b0, float b1, float b2, float b3)
+{
+    v4 r = v4_mul(a[0], v4_splat(b0));
+    r = v4_add(r, v4_mul(a[1], v4_splat(b1)));
+    r = v4_add(r, v4_mul(a[2], v4_splat(b2)));
+    return v4_add(r, v4_mul(a[3], v4_splat(b3)));
+}
+
+void simd_mat4_mul(mat4x4 out, mat4x4 const a, mat4x4 const b)
+{
+    v4 columns[4] = { v4_load(a[0]), v4_load(a[1]), v4_load(a[2]), v4_load(a[3]) };
+    v4 r[4];
+    for (int c = 0; c < 4; c++) {
+        r[c] = combine(columns, b[c][0], b[c][1], b[c][2], b[c][3]);
+    }
+    for (int c = 0; c < 4; c++) {
+        v4_store(out[c], r[c]);
+    }
+}
+
+// Model matrix columns, the same expressions as linmath's mat4x4_from_quat then scale
+static inline void trs_columns(float m[4][4], const float p[3], const float q[4], const float s[3])
+{
+    float a = q[3], b = q[0], c = q[1], d = q[2];
+    float a2 = a * a, b2 = b * b, c2 = c * c, d2 = d * d;
+
+    m[0][0] = (a2 + b2 - c2 - d2) * s[0];
+    m[0][1] = 2.f * (b * c + a * d) * s[0];
+    m[0][2] = 2.f * (b * d - a * c) * s[0];
+    m[0][3] = 0.f;
+
+    m[1][0] = 2.f * (b * c - a * d) * s[1];
+    m[1][1] = (a2 - b2 + c2 - d2) * s[1];
+    m[1][2] = 2.f * (c * d + a * b) * s[1];
+    m[1][3] = 0.f;
+
+    m[2][0] = 2.f * (b * d + a * c) * s[2];
+    m[2][1] = 2.f * (c * d - a * b) * s[2];
+    m[2][2] = (a2 - b2 - c2 + d2) * s[2];
+    m[2][3] = 0.f;
+
+    m[3][0] = p[0];
+    m[3][1] = p[1];
+    m[3][2] = p[2];
+    m[3][3] = 1.f;
+}
+
+void simd_mat4_trs(mat4x4 out, const float position[3], const float rotation[4], const float scale[3])
+{
+    trs_columns(out, position, rotation, scale);
+}
+
+void simd_trs_batch(mat4x4* out, mat4x4 const prefix, const TransformComponent* transforms, uint32_t count)
+{
+    if (!prefix) {
+        for (uint32_t i = 0; i < count; i++) {
+            trs_columns(out[i], transforms[i].position, transforms[i].rotation, transforms[i].scale);
+        }
+        return;
+    }
+
+    v4 columns[4] = { v4_load(prefix[0]), v4_load(prefix[1]), v4_load(prefix[2]), v4_load(prefix[3]) };
+    for (uint32_t i = 0; i < count; i++) {
+        float m[4][4];
+        trs_columns(m, transforms[i].position, transforms[i].rotation, transforms[i].scale);
+        for (int c = 0; c < 4; c++) {
+            v4_store(out[i][c], combine(columns, m[c][0], m[c][1], m[c][2], m[c][3]));
+        }
+    }
+}
+
+// Four rotations at once with one lane per rotation: t = 2 (q x v), r = v + w t + q x t
+void simd_quat_rotate_batch(float (*out)[3], const float (*rotations)[4], const float (*vectors)[3], uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float (*q)[4] = rotations + i;
+        const float (*v)[3] = vectors + i;
+        v4 qx = v4_set(q[0][0], q[1][0], q[2][0], q[3][0]);
+        v4 qy = v4_set(q[0][1], q[1][1], q[2][1], q[3][1]);
+        v4 qz = v4_set(q[0][2], q[1][2], q[2][2], q[3][2]);
+        v4 qw = v4_set(q[0][3], q[1][3], q[2][3], q[3][3]);
+        v4 vx = v4_set(v[0][0], v[1][0], v[2][0], v[3][0]);
+        v4 vy = v4_set(v[0][1], v[1][1], v[2][1], v[3][1]);
+        v4 vz = v4_set(v[0][2], v[1][2], v[2][2], v[3][2]);
+
+        v4 two = v4_splat(2.0f);
+        v4 tx = v4_mul(v4_sub(v4_mul(qy, vz), v4_mul(qz, vy)), two);
+        v4 ty = v4_mul(v4_sub(v4_mul(qz, vx), v4_mul(qx, vz)), two);
+        v4 tz = v4_mul(v4_sub(v4_mul(qx, vy), v4_mul(qy, vx)), two);
+
+        v4 ux = v4_sub(v4_mul(qy, tz), v4_mul(qz, ty));
+        v4 uy = v4_sub(v4_mul(qz, tx), v4_mul(qx, tz));
+        v4 uz = v4_sub(v4_mul(qx, ty), v4_mul(qy, tx));
+
+        float rx[4], ry[4], rz[4];
+        v4_store(rx, v4_add(v4_add(vx, v4_mul(tx, qw)), ux));
+        v4_store(ry, v4_add(v4_add(vy, v4_mul(ty, qw)), uy));
+        v4_store(rz, v4_add(v4_add(vz, v4_mul(tz, qw)), uz));
+        for (int k = 0; k < 4; k++) {
+            out[i + k][0] = rx[k];
+            out[i + k][1] = ry[k];
+            out[i + k][2] = rz[k];
+        }
+    }
+    for (; i < count; i++) {
+        const float* q = rotations[i];
+        const float* v = vectors[i];
+        float t[3] = {
+            (q[1] * v[2] - q[2] * v[1]) * 2.0f,
+            (q[2] * v[0] - q[0] * v[2]) * 2.0f,
+            (q[0] * v[1] - q[1] * v[0]) * 2.0f,
+        };
+        out[i][0] = v[0] + t[0] * q[3] + (q[1] * t[2] - q[2] * t[1]);
+        out[i][1] = v[1] + t[1] * q[3] + (q[2] * t[0] - q[0] * t[2]);
+        out[i][2] = v[2] + t[2] * q[3] + (q[0] * t[1] - q[1] * t[0]);
+    }
+}
+
+/*
+  Benchmark
+ */
+#define SIMD_MATH_TOLERANCE 1e-4f   // Relative, allows for differently fused multiply-adds
+
+static float random_float(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+static double seconds_since(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Largest difference relative to the magnitude of the reference values
+static float max_relative_error(const float* a, const float* b, size_t n)
+{
+    float worst = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        float error = fabsf(a[i] - b[i]) / fmaxf(1.0f, fabsf(b[i]));
+        if (error > worst) worst = error;
+    }
+    return worst;
+}
+
+static size_t count_exact(const float* a, const float* b, size_t n)
+{
+    size_t exact = 0;
+    for (size_t i = 0; i < n; i++) exact += a[i] == b[i];
+    return exact;
+}
+
+int simd_math_benchmark(uint32_t count)
+{
+    // Runs on its own and sizes its arrays from the command line, the game's budget does not apply
+    memory_set_budget(MEMORY_TAG_DEBUG, 0, 0);
+    TransformComponent* transforms = memory_alloc(MEMORY_TAG_DEBUG, sizeof(TransformComponent) * count);
+    mat4x4* expected = memory_alloc(MEMORY_TAG_DEBUG, sizeof(mat4x4) * count);
+    mat4x4* actual = memory_alloc(MEMORY_TAG_DEBUG, sizeof(mat4x4) * count);
+    float (*vectors)[3] = memory_alloc(MEMORY_TAG_DEBUG, sizeof(float[3]) * count);
+    float (*rotations)[4] = memory_alloc(MEMORY_TAG_DEBUG, sizeof(float[4]) * count);
+    float (*rotated_expected)[3] = memory_alloc(MEMORY_TAG_DEBUG, sizeof(float[3]) * count);
+    float (*rotated_actual)[3] = memory_alloc(MEMORY_TAG_DEBUG, sizeof(float[3]) * count);
+    int result = 1;
+    if (!transforms || !expected || !actual || !vectors || !rotations || !rotated_expected || !rotated_actual) {
+        fprintf(stderr, "bench-math: out of memory for %u transforms\n", count);
+        goto done;
+    }
+
+    srand(1);
+    for (uint32_t i = 0; i < count; i++) {
+        vec3 axis = { random_float(-1, 1), random_float(-1, 1) + 2.0f, random_float(-1, 1) };
+        TransformComponent* t = &transforms[i];
+        quat_rotate(t->rotation, random_float(-3.14f, 3.14f), axis);
+        for (int k = 0; k < 3; k++) {
+            t->position[k] = random_float(-100, 100);
+            t->scale[k] = random_float(0.1f, 4.0f);
+            vectors[i][k] = random_float(-10, 10);
+        }
+        memcpy(rotations[i], t->rotation, sizeof(rotations[i]));
+    }
+
+    mat4x4 view, proj, view_proj;
+    mat4x4_look_at(view, (vec3){ 0, 20, -30 }, (vec3){ 0, 0, 0 }, (vec3){ 0, 1, 0 });
+    mat4x4_perspective(proj, 45.0f * (3.1415926535f / 180.0f), 4.0f / 3.0f, 0.1f, 200.0f);
+    mat4x4_mul(view_proj, proj, view);
+
+    // The scalar path render_extract used: translate, rotate and scale in place, then multiply
+    clock_t start = clock();
+    for (uint32_t i = 0; i < count; i++) {
+        const TransformComponent* t = &transforms[i];
+        mat4x4 model, rot, scale;
+        mat4x4_identity(model);
+        mat4x4_translate_in_place(model, t->position[0], t->position[1], t->position[2]);
+        mat4x4_from_quat(rot, t->rotation);
+        mat4x4_mul(model, model, rot);
+        mat4x4_identity(scale);
+        scale[0][0] = t->scale[0];
+        scale[1][1] = t->scale[1];
+        scale[2][2] = t->scale[2];
+        mat4x4_mul(model, model, scale);
+        mat4x4_mul(expected[i], view_proj, model);
+    }
+    double linmath_trs = seconds_since(start);
+
+    start = clock();
+    simd_trs_batch(actual, view_proj, transforms, count);
+    double simd_trs = seconds_since(start);
+
+    size_t values = (size_t)count * 16;
+    float trs_error = max_relative_error(&actual[0][0][0], &expected[0][0][0], values);
+    size_t trs_exact = count_exact(&actual[0][0][0], &expected[0][0][0], values);
+
+    start = clock();
+    for (uint32_t i = 0; i < count; i++) {
+        mat4x4_mul(expected[i], view_proj, expected[i]);
+    }
+    double linmath_mul = seconds_since(start);
+
+    start = clock();
+    for (uint32_t i = 0; i < count; i++) {
+        simd_mat4_mul(actual[i], view_proj, actual[i]);
+    }
+    double simd_mul = seconds_since(start);
+    float mul_error = max_relative_error(&actual[0][0][0], &expected[0][0][0], values);
+
+    start = clock();
+    for (uint32_t i = 0; i < count; i++) {
+        quat_mul_vec3(rotated_expected[i], rotations[i], vectors[i]);
+    }
+    double linmath_rotate = seconds_since(start);
+
+    start = clock();
+    simd_quat_rotate_batch(rotated_actual, (const float (*)[4])rotations, (const float (*)[3])vectors, count);
+    double simd_rotate = seconds_since(start);
+    float rotate_error = max_relative_error(&rotated_actual[0][0], &rotated_expected[0][0], (size_t)count * 3);
+
+    printf("bench-math: %u transforms, %s backend\n", count, simd_math_backend());
+    printf("  trs * view_proj  linmath %7.3f ms  simd %7.3f ms  (%.1fx)  max error %.2g, %.1f%% exact\n",
+           linmath_trs * 1e3, simd_trs * 1e3, simd_trs > 0 ? linmath_trs / simd_trs : 0.0,
+           trs_error, 100.0 * (double)trs_exact / (double)values);
+    printf("  mat4 multiply    linmath %7.3f ms  simd %7.3f ms  (%.1fx)  max error %.2g\n",
+           linmath_mul * 1e3, simd_mul * 1e3, simd_mul > 0 ? linmath_mul / simd_mul : 0.0, mul_error);
+    printf("  quat rotate      linmath %7.3f ms  simd %7.3f ms  (%.1fx)  max error %.2g\n",
+           linmath_rotate * 1e3, simd_rotate * 1e3, simd_rotate > 0 ? linmath_rotate / simd_rotate : 0.0,
+           rotate_error);
+
+    bool agree = trs_error <= SIMD_MATH_TOLERANCE && mul_error <= SIMD_MATH_TOLERANCE &&
+                 rotate_error <= SIMD_MATH_TOLERANCE;
+    if (!agree) {
+        fprintf(stderr, "bench-math: results differ from linmath by more than %g\n", SIMD_MATH_TOLERANCE);
+    }
+
+    result = agree ? 0 : 1;
+
+done:
+    memory_free(transforms);
+    memory_free(expected);
+    memory_free(actual);
+    memory_free(vectors);
+    memory_free(rotations);
+    memory_free(rotated_expected);
+    memory_free(rotated_actual);
+    return result;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "transform.h"
+#include "../libs/linmath/linmath.h"
+
+/*
+  Vectorized versions of the matrix work render_extract does for every
+  entity: 4x4 multiply, translation-rotation-scale composition and
+  quaternion rotation, plus batch calls that convert many transforms at
+  once. SSE on x86-64, NEON on arm64, plain C elsewhere or when built
+  with -DSIMD_MATH_DISABLED. AVX2 would need its own compile flags and
+  a runtime check; four-wide columns already fill a 4x4 matrix.
+
+  Matrices are linmath's column-major mat4x4. Every product is summed in
+  linmath's order, so results match linmath exactly unless the compiler
+  fuses multiply-adds differently on one side. --bench-math checks this.
+ */
+
+const char* simd_math_backend(void);
+
+// out = a * b, out may alias either
+void simd_mat4_mul(mat4x4 out, mat4x4 const a, mat4x4 const b);
+// out = T(position) * R(rotation) * S(scale), linmath's translate/from_quat/scale sequence
+void simd_mat4_trs(mat4x4 out, const float position[3], const float rotation[4], const float scale[3]);
+
+// out[i] = prefix * TRS(transforms[i]), `prefix` NULL for the bare model matrices
+void simd_trs_batch(mat4x4* out, mat4x4 const prefix, const TransformComponent* transforms, uint32_t count);
+// out[i] = rotations[i] applied to vectors[i], linmath's quat_mul_vec3
+void simd_quat_rotate_batch(float (*out)[3], const float (*rotations)[4], const float (*vectors)[3], uint32_t count);
+
+// Times linmath against the batch calls on `count` random transforms and checks that they agree,
+// returns 0 when they do
+int simd_math_benchmark(uint32_t count);
@@ -0,0 +1,200 @@
+#define _POSIX_C_SOURCE 200809L
+#include "snapshot.h"
+#include "transform.h"
+#include "camera.h"
+#include "physics.h"
+#include "projectile.h"
+#include "zombie.h"
+#include "flowfield.h"
+#include "profile.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef struct {
+    ComponentType type;
+    uint32_t stride;
+} SnapshotPool;
+
+// Every pool except render, whose GPU handles don't survive a process
+static const SnapshotPool snapshot_pools[] = {
+    { COMPONENT_TRANSFORM, sizeof(TransformComponent) },
+    { COMPONENT_CAMERA, sizeof(CameraComponent) },
+    { COMPONENT_FOLLOW, sizeof(FollowComponent) },
+    { COMPONENT_COLLISION, sizeof(CollisionComponent) },
+    { COMPONENT_PROJECTILE, sizeof(ProjectileComponent) },
+    { COMPONENT_VELOCITY, sizeof(VelocityComponent) },
+    { COMPONENT_LIFETIME, sizeof(LifetimeComponent) },
+    { COMPONENT_HEALTH, sizeof(HealthComponent) },
+    { COMPONENT_DAMAGE, sizeof(DamageComponent) },
+    { COMPONENT_ZOMBIE, sizeof(ZombieComponent) },
+};
+#define SNAPSHOT_POOL_COUNT (sizeof(snapshot_pools) / sizeof(snapshot_pools[0]))
+#define SNAPSHOT_SECTION_COUNT (SNAPSHOT_POOL_COUNT + 1)
+
+static uint64_t align_up(uint64_t value)
+{
+    return (value + SNAPSHOT_ALIGNMENT - 1) & ~(uint64_t)(SNAPSHOT_ALIGNMENT - 1);
+}
+
+static void write_padding(FILE* f, uint64_t from, uint64_t to)
+{
+    static const uint8_t zeros[SNAPSHOT_ALIGNMENT] = {0};
+    if (to > from) fwrite(zeros, 1, (size_t)(to - from), f);
+}
+
+bool snapshot_save(const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "snapshot: failed to open %s for writing\n", path);
+        return false;
+    }
+
+    const void* payloads[SNAPSHOT_SECTION_COUNT];
+    SnapshotSection sections[SNAPSHOT_SECTION_COUNT];
+    uint64_t offset = align_up(sizeof(SnapshotHeader) + sizeof(sections));
+
+    sections[0] = (SnapshotSection){ .component = COMPONENT_NONE, .stride = sizeof(Registry),
+                                     .offset = offset, .size = sizeof(Registry) };
+    payloads[0] = &registry;
+    offset = align_up(offset + sections[0].size);
+
+    for (uint32_t i = 0; i < SNAPSHOT_POOL_COUNT; i++) {
+        size_t size = 0;
+        payloads[i + 1] = ecs_get_pool(snapshot_pools[i].type, &size);
+        sections[i + 1] = (SnapshotSection){ .component = snapshot_pools[i].type, .stride = snapshot_pools[i].stride,
+                                             .offset = offset, .size = size };
+        offset = align_up(offset + size);
+    }
+
+    SnapshotHeader header = {
+        .magic = SNAPSHOT_MAGIC,
+        .version = SNAPSHOT_VERSION,
+        .max_entities = MAX_ENTITIES,
+        .section_count = SNAPSHOT_SECTION_COUNT,
+        .file_size = offset,
+        .physics_time = physics_time(),
+    };
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(sections, sizeof(sections), 1, f);
+    uint64_t written = sizeof(header) + sizeof(sections);
+
+    for (uint32_t i = 0; i < SNAPSHOT_SECTION_COUNT; i++) {
+        write_padding(f, written, sections[i].offset);
+        fwrite(payloads[i], 1, (size_t)sections[i].size, f);
+        written = sections[i].offset + sections[i].size;
+    }
+    write_padding(f, written, header.file_size);
+
+    bool ok = !ferror(f);
+    fclose(f);
+    if (ok) printf("snapshot: saved %u entities to %s\n", registry.entity_count, path);
+    return ok;
+}
+
+static bool validate(const uint8_t* data, uint64_t file_size)
+{
+    if (file_size < sizeof(SnapshotHeader)) return false;
+    const SnapshotHeader* header = (const SnapshotHeader*)data;
+    if (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION ||
+        header->max_entities != MAX_ENTITIES || header->file_size != file_size) {
+        return false;
+    }
+    uint64_t table_end = sizeof(SnapshotHeader) + (uint64_t)header->section_count * sizeof(SnapshotSection);
+    if (table_end > file_size) return false;
+
+    const SnapshotSection* sections = (const SnapshotSection*)(data + sizeof(SnapshotHeader));
+    for (uint32_t i = 0; i < header->section_count; i++) {
+        if (sections[i].offset > file_size || sections[i].size > file_size - sections[i].offset) return false;
+    }
+    return true;
+}
+
+bool snapshot_load(const char* path, const RenderComponent* render)
+{
+    PROFILE_BEGIN("snapshot_load");
+    bool ok = false;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "snapshot: failed to open %s\n", path);
+        PROFILE_END("snapshot_load");
+        return false;
+    }
+
+    struct stat st;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "snapshot: failed to map %s\n", path);
+        PROFILE_END("snapshot_load");
+        return false;
+    }
+
+    const uint8_t* data = (const uint8_t*)mapped;
+    if (!validate(data, (uint64_t)st.st_size)) {
+        fprintf(stderr, "snapshot: %s is not a compatible version %d snapshot\n", path, SNAPSHOT_VERSION);
+        goto done;
+    }
+
+    const SnapshotHeader* header = (const SnapshotHeader*)data;
+    const SnapshotSection* sections = (const SnapshotSection*)(data + sizeof(SnapshotHeader));
+
+    // Check every section before touching the world so a bad file leaves it intact
+    bool has_registry = false;
+    for (uint32_t i = 0; i < header->section_count; i++) {
+        size_t size = 0;
+        if (sections[i].component == COMPONENT_NONE) {
+            size = sizeof(Registry);
+            has_registry = true;
+        } else if (!ecs_get_pool((ComponentType)sections[i].component, &size)) {
+            continue; // Unknown pool from a newer build, skip it
+        }
+        uint64_t stride = sections[i].component == COMPONENT_NONE ? size : size / MAX_ENTITIES;
+        if (sections[i].size != size || sections[i].stride != stride) {
+            fprintf(stderr, "snapshot: section %u layout does not match this build\n", i);
+            goto done;
+        }
+    }
+    if (!has_registry) goto done;
+
+    ecs_init();
+    for (uint32_t i = 0; i < header->section_count; i++) {
+        const void* src = data + sections[i].offset;
+        if (sections[i].component == COMPONENT_NONE) {
+            memcpy(&registry, src, sizeof(Registry));
+            continue;
+        }
+        void* pool = ecs_get_pool((ComponentType)sections[i].component, NULL);
+        if (pool) memcpy(pool, src, (size_t)sections[i].size);
+    }
+
+    // Rebind render handles for this process
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        if (!registry.alive[e] || !(registry.component_masks[e] & COMPONENT_RENDER)) continue;
+        if (render) {
+            entity_set_render(e, *render);
+        } else {
+            registry.component_masks[e] &= ~(uint32_t)COMPONENT_RENDER;
+        }
+    }
+
+    flowfield_mark_obstacles_dirty();
+    physics_set_time(header->physics_time);
+    physics_reset();
+
+    printf("snapshot: loaded %u entities from %s\n", registry.entity_count, path);
+    ok = true;
+
+done:
+    munmap(mapped, (size_t)st.st_size);
+    PROFILE_END("snapshot_load");
+    return ok;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ecs.h"
+#include "render.h"
+
+#define SNAPSHOT_MAGIC     0x504e535au // "ZSNP"
+#define SNAPSHOT_VERSION   4
+#define SNAPSHOT_ALIGNMENT 64
+
+/*
+  File layout:
+    SnapshotHeader
+    SnapshotSection[section_count]
+    section payloads, each SNAPSHOT_ALIGNMENT aligned
+
+  The registry and every component pool are stored as the raw
+  MAX_ENTITIES-slot arrays, so loading is a bounds check plus one copy
+  per section. RenderComponent holds GPU handles and is not stored.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t max_entities;
+    uint32_t section_count;
+    uint64_t file_size;
+    double physics_time;  // Clock that lifetime expiry ticks are relative to
+} SnapshotHeader;
+
+typedef struct {
+    uint32_t component;   // ComponentType, COMPONENT_NONE for the registry
+    uint32_t stride;      // Size of one slot, must match this build
+    uint64_t offset;      // From the start of the file
+    uint64_t size;
+} SnapshotSection;
+
+bool snapshot_save(const char* path);
+
+// Entities that had a RenderComponent get `render`, or lose the component if it is NULL
+bool snapshot_load(const char* path, const RenderComponent* render);
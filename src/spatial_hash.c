@@ -0,0 +1,110 @@
+#include "spatial_hash.h"
+
+#include <math.h>
+#include <string.h>
+
+void spatial_hash_begin(SpatialHash* hash, float cell_size)
+{
+    hash->cell_size = cell_size;
+    hash->inv_cell_size = 1.0f / cell_size;
+    hash->count = 0;
+    hash->overflowed = false;
+}
+
+int spatial_hash_coord(const SpatialHash* hash, float v)
+{
+    return (int)floorf(v * hash->inv_cell_size);
+}
+
+uint32_t spatial_hash_bucket(int cx, int cz)
+{
+    return (((uint32_t)cx * 73856093u) ^ ((uint32_t)cz * 19349663u)) & (SPATIAL_HASH_BUCKETS - 1);
+}
+
+static bool stage(SpatialHash* hash, Entity e, uint32_t bucket)
+{
+    if (hash->count >= SPATIAL_HASH_MAX_ENTRIES) {
+        hash->overflowed = true;
+        return false;
+    }
+    hash->staged_bucket[hash->count] = bucket;
+    hash->staged_entity[hash->count] = e;
+    hash->count++;
+    return true;
+}
+
+bool spatial_hash_insert(SpatialHash* hash, Entity e, const float position[3])
+{
+    int cx = spatial_hash_coord(hash, position[0]);
+    int cz = spatial_hash_coord(hash, position[2]);
+    return stage(hash, e, spatial_hash_bucket(cx, cz));
+}
+
+bool spatial_hash_insert_aabb(SpatialHash* hash, Entity e, const float min[3], const float max[3])
+{
+    int x0 = spatial_hash_coord(hash, min[0]);
+    int x1 = spatial_hash_coord(hash, max[0]);
+    int z0 = spatial_hash_coord(hash, min[2]);
+    int z1 = spatial_hash_coord(hash, max[2]);
+
+    uint32_t first = hash->count;
+    for (int z = z0; z <= z1; z++) {
+        for (int x = x0; x <= x1; x++) {
+            uint32_t bucket = spatial_hash_bucket(x, z);
+            // Skip cells that alias a bucket this entity is already in
+            bool duplicate = false;
+            for (uint32_t i = first; i < hash->count && !duplicate; i++) {
+                duplicate = hash->staged_bucket[i] == bucket;
+            }
+            if (!duplicate && !stage(hash, e, bucket)) return false;
+        }
+    }
+    return true;
+}
+
+void spatial_hash_end(SpatialHash* hash)
+{
+    memset(hash->bucket_start, 0, sizeof(hash->bucket_start));
+    for (uint32_t i = 0; i < hash->count; i++) {
+        hash->bucket_start[hash->staged_bucket[i] + 1]++;
+    }
+    for (uint32_t b = 0; b < SPATIAL_HASH_BUCKETS; b++) {
+        hash->bucket_start[b + 1] += hash->bucket_start[b];
+    }
+
+    // Scatter using bucket_start as running cursors, then shift them back
+    for (uint32_t i = 0; i < hash->count; i++) {
+        hash->entries[hash->bucket_start[hash->staged_bucket[i]]++] = hash->staged_entity[i];
+    }
+    for (uint32_t b = SPATIAL_HASH_BUCKETS; b > 0; b--) {
+        hash->bucket_start[b] = hash->bucket_start[b - 1];
+    }
+    hash->bucket_start[0] = 0;
+}
+
+const Entity* spatial_hash_bucket_entries(const SpatialHash* hash, uint32_t bucket, uint32_t* out_count)
+{
+    *out_count = hash->bucket_start[bucket + 1] - hash->bucket_start[bucket];
+    return &hash->entries[hash->bucket_start[bucket]];
+}
+
+const Entity* spatial_hash_cell(const SpatialHash* hash, int cx, int cz, uint32_t* out_count)
+{
+    return spatial_hash_bucket_entries(hash, spatial_hash_bucket(cx, cz), out_count);
+}
+
+int spatial_hash_neighborhood(int cx, int cz, uint32_t out_buckets[9])
+{
+    int count = 0;
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            uint32_t bucket = spatial_hash_bucket(cx + dx, cz + dz);
+            bool duplicate = false;
+            for (int i = 0; i < count && !duplicate; i++) {
+                duplicate = out_buckets[i] == bucket;
+            }
+            if (!duplicate) out_buckets[count++] = bucket;
+        }
+    }
+    return count;
+}
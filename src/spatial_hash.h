@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ecs.h"
+
+/*
+  Uniform grid on the XZ plane hashed into a fixed bucket table, rebuilt
+  from scratch each tick. Inserts are staged, then spatial_hash_end
+  counting-sorts them so every bucket is one contiguous run of entities.
+  Distinct cells can share a bucket, so queries must still test distance.
+ */
+#define SPATIAL_HASH_BUCKETS     4096                // Power of two
+#define SPATIAL_HASH_MAX_ENTRIES (MAX_ENTITIES * 4)  // An AABB may cover several cells
+
+typedef struct {
+    float cell_size;
+    float inv_cell_size;
+    uint32_t count;
+    bool overflowed;
+    uint32_t bucket_start[SPATIAL_HASH_BUCKETS + 1];
+    Entity entries[SPATIAL_HASH_MAX_ENTRIES];
+    uint32_t staged_bucket[SPATIAL_HASH_MAX_ENTRIES];
+    Entity staged_entity[SPATIAL_HASH_MAX_ENTRIES];
+} SpatialHash;
+
+void spatial_hash_begin(SpatialHash* hash, float cell_size);
+bool spatial_hash_insert(SpatialHash* hash, Entity e, const float position[3]);
+bool spatial_hash_insert_aabb(SpatialHash* hash, Entity e, const float min[3], const float max[3]);
+void spatial_hash_end(SpatialHash* hash);
+
+int spatial_hash_coord(const SpatialHash* hash, float v);
+uint32_t spatial_hash_bucket(int cx, int cz);
+
+const Entity* spatial_hash_bucket_entries(const SpatialHash* hash, uint32_t bucket, uint32_t* out_count);
+
+// Entities in the bucket holding cell (cx, cz)
+const Entity* spatial_hash_cell(const SpatialHash* hash, int cx, int cz, uint32_t* out_count);
+
+// Buckets of the 3x3 cells around (cx, cz) with duplicates removed, returns the count
+int spatial_hash_neighborhood(int cx, int cz, uint32_t out_buckets[9]);
@@ -0,0 +1,300 @@
+#include "statehash.h"
+#include "ecs.h"
+#include "transform.h"
+#include "physics.h"
+#include "profile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+  xxHash64-style hash: four independent 64-bit lanes over 32-byte stripes,
+  so the main loop has no cross-lane dependency and pipelines/vectorizes.
+  Components are not hashed as raw pool bytes: struct padding and the
+  stale contents of dead slots would make equal states hash differently.
+  Each section packs the fields of the live entities that have the
+  component, tagged with the entity index, into a staging buffer and
+  hashes it a chunk at a time.
+ */
+#define STATEHASH_CHUNK 4096
+#define PRIME64_1 0x9E3779B185EBCA87ull
+#define PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define PRIME64_3 0x165667B19E3779F9ull
+#define PRIME64_4 0x85EBCA77C2B2AE63ull
+#define PRIME64_5 0x27D4EB2F165667C5ull
+
+static const char* section_names[STATEHASH_SECTION_COUNT] = {
+    [STATEHASH_REGISTRY] = "registry",
+    [STATEHASH_TRANSFORM] = "transform",
+    [STATEHASH_VELOCITY] = "velocity",
+    [STATEHASH_HEALTH] = "health",
+    [STATEHASH_LIFETIME] = "lifetime",
+    [STATEHASH_COLLISION] = "collision",
+};
+
+static const ComponentType section_components[STATEHASH_SECTION_COUNT] = {
+    [STATEHASH_REGISTRY] = COMPONENT_NONE,
+    [STATEHASH_TRANSFORM] = COMPONENT_TRANSFORM,
+    [STATEHASH_VELOCITY] = COMPONENT_VELOCITY,
+    [STATEHASH_HEALTH] = COMPONENT_HEALTH,
+    [STATEHASH_LIFETIME] = COMPONENT_LIFETIME,
+    [STATEHASH_COLLISION] = COMPONENT_COLLISION,
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t section_count;
+    uint32_t record_size;
+} StateHashHeader;
+
+static FILE* log_file;
+static uint32_t log_tick;
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t lane)
+{
+    acc += lane * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+uint64_t statehash_bytes(const void* data, size_t size, uint64_t seed)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    const uint8_t* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t acc[4] = {
+            seed + PRIME64_1 + PRIME64_2,
+            seed + PRIME64_2,
+            seed,
+            seed - PRIME64_1,
+        };
+        const uint8_t* limit = end - 32;
+        do {
+            for (int lane = 0; lane < 4; lane++) {
+                acc[lane] = hash_round(acc[lane], read64(p + lane * 8));
+            }
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl64(acc[0], 1) + rotl64(acc[1], 7) + rotl64(acc[2], 12) + rotl64(acc[3], 18);
+        for (int lane = 0; lane < 4; lane++) {
+            h ^= hash_round(0, acc[lane]);
+            h = h * PRIME64_1 + PRIME64_4;
+        }
+    } else {
+        h = seed + PRIME64_5;
+    }
+
+    h += (uint64_t)size;
+    for (; p + 8 <= end; p += 8) {
+        h ^= hash_round(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    for (; p < end; p++) {
+        h ^= (*p) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+typedef struct {
+    uint8_t data[STATEHASH_CHUNK];
+    size_t used;
+    uint64_t hash;
+} HashStream;
+
+static void stream_put(HashStream* stream, const void* data, size_t size)
+{
+    if (stream->used + size > sizeof(stream->data)) {
+        stream->hash = statehash_bytes(stream->data, stream->used, stream->hash);
+        stream->used = 0;
+    }
+    memcpy(stream->data + stream->used, data, size);
+    stream->used += size;
+}
+
+static void stream_put_bool(HashStream* stream, bool value)
+{
+    uint8_t byte = value ? 1 : 0;
+    stream_put(stream, &byte, sizeof(byte));
+}
+
+// Field by field, never the whole struct, so padding stays out
+static void pack_component(HashStream* stream, StateHashSection section, Entity e)
+{
+    switch (section) {
+        case STATEHASH_TRANSFORM: {
+            const TransformComponent* t = entity_get_transform_unchecked(e);
+            stream_put(stream, t->position, sizeof(t->position));
+            stream_put(stream, t->rotation, sizeof(t->rotation));
+            stream_put(stream, t->scale, sizeof(t->scale));
+            stream_put_bool(stream, t->dirty);
+        } break;
+        case STATEHASH_VELOCITY: {
+            const VelocityComponent* v = entity_get_velocity_unchecked(e);
+            stream_put(stream, v->velocity, sizeof(v->velocity));
+        } break;
+        case STATEHASH_HEALTH: {
+            const HealthComponent* h = entity_get_health_unchecked(e);
+            stream_put(stream, &h->current_health, sizeof(h->current_health));
+            stream_put(stream, &h->max_health, sizeof(h->max_health));
+        } break;
+        case STATEHASH_LIFETIME: {
+            const LifetimeComponent* l = entity_get_lifetime_unchecked(e);
+            stream_put(stream, &l->lifetime, sizeof(l->lifetime));
+            stream_put(stream, &l->expire_tick, sizeof(l->expire_tick));
+        } break;
+        case STATEHASH_COLLISION: {
+            const CollisionComponent* c = entity_get_collision_unchecked(e);
+            stream_put(stream, c->min, sizeof(c->min));
+            stream_put(stream, c->max, sizeof(c->max));
+            stream_put(stream, c->size, sizeof(c->size));
+            stream_put(stream, c->center_offset, sizeof(c->center_offset));
+            stream_put_bool(stream, c->is_static);
+            stream_put(stream, &c->layer, sizeof(c->layer));
+            stream_put(stream, &c->mask, sizeof(c->mask));
+        } break;
+        default: break;
+    }
+}
+
+void statehash_compute(StateHashRecord* out)
+{
+    PROFILE_BEGIN("statehash_compute");
+
+    // Only hash up to the highest live slot, so cost follows the live entity count
+    uint32_t slots = MAX_ENTITIES;
+    while (slots > 0 && !registry.alive[slots - 1]) slots--;
+
+    for (int s = 0; s < STATEHASH_SECTION_COUNT; s++) {
+        if (s == STATEHASH_REGISTRY) {
+            uint64_t h = statehash_bytes(registry.alive, slots * sizeof(registry.alive[0]), 0);
+            h = statehash_bytes(registry.component_masks, slots * sizeof(registry.component_masks[0]), h);
+            out->hashes[s] = statehash_bytes(&registry.entity_count, sizeof(registry.entity_count), h);
+            continue;
+        }
+        HashStream stream = { .hash = (uint64_t)s };
+        for (Entity e = 0; e < slots; e++) {
+            if (!registry.alive[e] || !(registry.component_masks[e] & section_components[s])) continue;
+            stream_put(&stream, &e, sizeof(e));
+            pack_component(&stream, (StateHashSection)s, e);
+        }
+        out->hashes[s] = statehash_bytes(stream.data, stream.used, stream.hash);
+    }
+
+    PROFILE_END("statehash_compute");
+}
+
+bool statehash_log_begin(const char* path)
+{
+    log_file = fopen(path, "wb");
+    if (!log_file) {
+        fprintf(stderr, "statehash: failed to open %s for writing\n", path);
+        return false;
+    }
+    StateHashHeader header = {
+        .magic = STATEHASH_MAGIC,
+        .version = STATEHASH_VERSION,
+        .section_count = STATEHASH_SECTION_COUNT,
+        .record_size = sizeof(StateHashRecord),
+    };
+    fwrite(&header, sizeof(header), 1, log_file);
+    log_tick = 0;
+    return true;
+}
+
+void statehash_log_tick(void)
+{
+    if (!log_file) return;
+
+    StateHashRecord record = { .tick = log_tick++ };
+    statehash_compute(&record);
+    fwrite(&record, sizeof(record), 1, log_file);
+}
+
+void statehash_log_end(void)
+{
+    if (!log_file) return;
+    fclose(log_file);
+    log_file = NULL;
+}
+
+static FILE* open_log(const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "statehash: failed to open %s\n", path);
+        return NULL;
+    }
+    StateHashHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != STATEHASH_MAGIC ||
+        header.version != STATEHASH_VERSION || header.section_count != STATEHASH_SECTION_COUNT ||
+        header.record_size != sizeof(StateHashRecord)) {
+        fprintf(stderr, "statehash: %s is not a version %d hash log\n", path, STATEHASH_VERSION);
+        fclose(f);
+        return NULL;
+    }
+    return f;
+}
+
+int statehash_compare(const char* path_a, const char* path_b)
+{
+    FILE* a = open_log(path_a);
+    FILE* b = open_log(path_b);
+    int result = 2;
+    if (!a || !b) goto done;
+
+    StateHashRecord ra, rb;
+    uint32_t ticks = 0;
+    for (;;) {
+        bool has_a = fread(&ra, sizeof(ra), 1, a) == 1;
+        bool has_b = fread(&rb, sizeof(rb), 1, b) == 1;
+        if (!has_a || !has_b) {
+            if (has_a != has_b) {
+                printf("statehash: runs match for %u ticks, then %s ends early\n",
+                       ticks, has_a ? path_b : path_a);
+                result = 1;
+            } else {
+                printf("statehash: runs match for all %u ticks\n", ticks);
+                result = 0;
+            }
+            goto done;
+        }
+        for (int s = 0; s < STATEHASH_SECTION_COUNT; s++) {
+            if (ra.hashes[s] != rb.hashes[s]) {
+                printf("statehash: first divergence at tick %u in %s (%016llx != %016llx)\n",
+                       ra.tick, section_names[s],
+                       (unsigned long long)ra.hashes[s], (unsigned long long)rb.hashes[s]);
+                result = 1;
+                goto done;
+            }
+        }
+        ticks++;
+    }
+
+done:
+    if (a) fclose(a);
+    if (b) fclose(b);
+    return result;
+}
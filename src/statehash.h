@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define STATEHASH_MAGIC   0x4853485au // "ZHSH"
+#define STATEHASH_VERSION 2
+
+typedef enum {
+    STATEHASH_REGISTRY,
+    STATEHASH_TRANSFORM,
+    STATEHASH_VELOCITY,
+    STATEHASH_HEALTH,
+    STATEHASH_LIFETIME,
+    STATEHASH_COLLISION,
+    STATEHASH_SECTION_COUNT // Must be last
+} StateHashSection;
+
+typedef struct {
+    uint32_t tick;
+    uint32_t reserved;
+    uint64_t hashes[STATEHASH_SECTION_COUNT];
+} StateHashRecord;
+
+uint64_t statehash_bytes(const void* data, size_t size, uint64_t seed);
+void statehash_compute(StateHashRecord* out);
+
+// Per-run hash stream, one record per simulation tick
+bool statehash_log_begin(const char* path);
+void statehash_log_tick(void);
+void statehash_log_end(void);
+
+// Reports the first tick and section where two hash logs diverge, returns 0 if they match
+int statehash_compare(const char* path_a, const char* path_b);
@@ -0,0 +1,141 @@
+#include "steering.h"
+#include "transform.h"
+#include "physics.h"
+#include "zombie.h"
+#include "profile.h"
+#include "lod.h"
+#include "arena.h"
+#include "memory.h"
+
+#include <math.h>
+#include <string.h>
+
+static SpatialHash horde_hash;
+
+// Results are staged so the pass only reads velocities. Each agent's slot is its index in the
+// hash's counting-sorted entries, so bucket_start is the per-bucket offset and every bucket can
+// run independently. Agents not steered this tick leave INVALID_ENTITY in their slot.
+typedef struct {
+    Entity entity;
+    float velocity[3];
+} SteeredAgent;
+
+const SpatialHash* steering_spatial_hash(void)
+{
+    return &horde_hash;
+}
+
+static void steer_bucket(uint32_t bucket, SteeredAgent* out)
+{
+    uint32_t count;
+    const Entity* agents = spatial_hash_bucket_entries(&horde_hash, bucket, &count);
+    if (out) out += horde_hash.bucket_start[bucket];
+
+    for (uint32_t i = 0; i < count; i++) {
+        Entity e = agents[i];
+        if (out) out[i].entity = INVALID_ENTITY;
+        // Still neighbors for others, just not steered this tick
+        if (!lod_is_due(e) || physics_is_sleeping(e)) continue;
+
+        // Only zombies with a transform and velocity are in the hash
+        TransformComponent* t = entity_get_transform_unchecked(e);
+        VelocityComponent* v = entity_get_velocity_unchecked(e);
+        ZombieComponent* z = entity_get_zombie_unchecked(e);
+
+        float separation[2] = {0.0f, 0.0f};
+        float alignment[2] = {0.0f, 0.0f};
+        int neighbors = 0;
+
+        uint32_t buckets[9];
+        int cx = spatial_hash_coord(&horde_hash, t->position[0]);
+        int cz = spatial_hash_coord(&horde_hash, t->position[2]);
+        int bucket_count = spatial_hash_neighborhood(cx, cz, buckets);
+
+        for (int b = 0; b < bucket_count && neighbors < STEERING_MAX_NEIGHBORS; b++) {
+            uint32_t other_count;
+            const Entity* others = spatial_hash_bucket_entries(&horde_hash, buckets[b], &other_count);
+            for (uint32_t j = 0; j < other_count && neighbors < STEERING_MAX_NEIGHBORS; j++) {
+                Entity o = others[j];
+                if (o == e) continue;
+                TransformComponent* ot = entity_get_transform_unchecked(o);
+                float dx = t->position[0] - ot->position[0];
+                float dz = t->position[2] - ot->position[2];
+                float dist2 = dx * dx + dz * dz;
+                if (dist2 >= STEERING_RADIUS * STEERING_RADIUS) continue;
+
+                if (dist2 < 1e-6f) {
+                    // Stacked exactly, split them deterministically by entity order
+                    dx = e < o ? 1.0f : -1.0f;
+                    dz = 0.0f;
+                    dist2 = 1e-2f;
+                }
+                separation[0] += dx / dist2;
+                separation[1] += dz / dist2;
+
+                VelocityComponent* ov = entity_get_velocity_unchecked(o);
+                alignment[0] += ov->velocity[0];
+                alignment[1] += ov->velocity[2];
+                neighbors++;
+            }
+        }
+
+        float vx = v->velocity[0];
+        float vz = v->velocity[2];
+        if (neighbors > 0) {
+            float inv = 1.0f / (float)neighbors;
+            vx += STEERING_ALIGNMENT_WEIGHT * (alignment[0] * inv - vx);
+            vz += STEERING_ALIGNMENT_WEIGHT * (alignment[1] * inv - vz);
+            vx += STEERING_SEPARATION_WEIGHT * z->speed * separation[0];
+            vz += STEERING_SEPARATION_WEIGHT * z->speed * separation[1];
+
+            float speed = sqrtf(vx * vx + vz * vz);
+            if (speed > z->speed) {
+                vx *= z->speed / speed;
+                vz *= z->speed / speed;
+            }
+        }
+
+        if (out) {
+            out[i] = (SteeredAgent){ .entity = e, .velocity = { vx, v->velocity[1], vz } };
+        } else {
+            // No staging buffer, later agents see this one's new velocity
+            v->velocity[0] = vx;
+            v->velocity[2] = vz;
+        }
+    }
+}
+
+void steering_init(void)
+{
+    MEMORY_REGISTER_STATIC(MEMORY_TAG_AI, horde_hash);
+}
+
+void steering_system_update(float delta_time)
+{
+    (void)delta_time;
+    PROFILE_BEGIN("steering_system_update");
+
+    const uint32_t required = COMPONENT_ZOMBIE | COMPONENT_TRANSFORM | COMPONENT_VELOCITY;
+    spatial_hash_begin(&horde_hash, STEERING_CELL_SIZE);
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        if (!entity_is_alive(e)) continue;
+        if ((registry.component_masks[e] & required) != required) continue;
+        spatial_hash_insert(&horde_hash, e, entity_get_transform_unchecked(e)->position);
+    }
+    spatial_hash_end(&horde_hash);
+
+    // The arena reports running out, steering then writes in place: still deterministic,
+    // just dependent on bucket order for one tick
+    SteeredAgent* steered_agents = ARENA_ALLOC(frame_arena(), SteeredAgent, horde_hash.count);
+    for (uint32_t bucket = 0; bucket < SPATIAL_HASH_BUCKETS; bucket++) {
+        steer_bucket(bucket, steered_agents);
+    }
+
+    for (uint32_t i = 0; steered_agents && i < horde_hash.count; i++) {
+        if (steered_agents[i].entity == INVALID_ENTITY) continue;
+        VelocityComponent* v = entity_get_velocity_unchecked(steered_agents[i].entity);
+        memcpy(v->velocity, steered_agents[i].velocity, sizeof(steered_agents[i].velocity));
+    }
+
+    PROFILE_END("steering_system_update");
+}
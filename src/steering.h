@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ecs.h"
+#include "spatial_hash.h"
+
+#define STEERING_CELL_SIZE         2.0f
+#define STEERING_RADIUS            1.6f   // Neighbors closer than this push apart
+#define STEERING_MAX_NEIGHBORS     8      // Bounds per-agent cost in dense crowds
+#define STEERING_SEPARATION_WEIGHT 1.5f
+#define STEERING_ALIGNMENT_WEIGHT  0.3f
+
+/*
+  Crowd steering for zombies. Runs after zombie_system_update has written
+  the flow-field velocity and blends in separation and alignment from
+  nearby zombies, found through a spatial hash rebuilt each tick.
+ */
+void steering_init(void);
+void steering_system_update(float delta_time);
+
+// The horde hash from the last update, for other systems' neighbor queries
+const SpatialHash* steering_spatial_hash(void);
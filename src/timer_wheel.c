@@ -0,0 +1,152 @@
+#include "timer_wheel.h"
+
+#include <string.h>
+
+_Static_assert(MAX_ENTITIES < TIMER_WHEEL_NONE, "timer nodes are indexed with uint16_t");
+
+#define ROOT_MASK  (TIMER_WHEEL_ROOT_SLOTS - 1)
+#define LEVEL_MASK (TIMER_WHEEL_LEVEL_SLOTS - 1)
+
+static uint32_t level_shift(int level)
+{
+    return TIMER_WHEEL_ROOT_BITS + (uint32_t)(level - 1) * TIMER_WHEEL_LEVEL_BITS;
+}
+
+static uint16_t level_slot(int level, uint32_t index)
+{
+    return (uint16_t)(TIMER_WHEEL_ROOT_SLOTS + (uint32_t)(level - 1) * TIMER_WHEEL_LEVEL_SLOTS + index);
+}
+
+static void link(TimerWheel* wheel, Entity e, uint16_t slot)
+{
+    TimerNode* node = &wheel->nodes[e];
+    node->slot = slot;
+    node->prev = TIMER_WHEEL_NONE;
+    node->next = wheel->heads[slot];
+    if (node->next != TIMER_WHEEL_NONE) {
+        wheel->nodes[node->next].prev = (uint16_t)e;
+    }
+    wheel->heads[slot] = (uint16_t)e;
+}
+
+static void unlink(TimerWheel* wheel, Entity e)
+{
+    TimerNode* node = &wheel->nodes[e];
+    if (node->prev != TIMER_WHEEL_NONE) {
+        wheel->nodes[node->prev].next = node->next;
+    } else {
+        wheel->heads[node->slot] = node->next;
+    }
+    if (node->next != TIMER_WHEEL_NONE) {
+        wheel->nodes[node->next].prev = node->prev;
+    }
+    node->slot = TIMER_WHEEL_NONE;
+}
+
+// Picks the finest level whose span still reaches the expiry tick
+static void place(TimerWheel* wheel, Entity e)
+{
+    TimerNode* node = &wheel->nodes[e];
+    uint32_t expire = node->expire_tick;
+    // Signed difference so overdue timers land in the slot processed next
+    int32_t delta = (int32_t)(expire - wheel->base);
+    if (delta < 0) {
+        expire = wheel->base;
+        delta = 0;
+    } else if ((uint32_t)delta > TIMER_WHEEL_MAX_DELAY) {
+        expire = wheel->base + TIMER_WHEEL_MAX_DELAY;
+        delta = TIMER_WHEEL_MAX_DELAY;
+    }
+
+    if ((uint32_t)delta < TIMER_WHEEL_ROOT_SLOTS) {
+        link(wheel, e, (uint16_t)(expire & ROOT_MASK));
+        return;
+    }
+    for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        uint32_t span_bits = level_shift(level) + TIMER_WHEEL_LEVEL_BITS;
+        if (level == TIMER_WHEEL_LEVELS - 1 || (uint32_t)delta < (1u << span_bits)) {
+            link(wheel, e, level_slot(level, (expire >> level_shift(level)) & LEVEL_MASK));
+            return;
+        }
+    }
+}
+
+// Re-places every timer of one coarse slot, returns the slot's index within its level
+static uint32_t cascade(TimerWheel* wheel, int level)
+{
+    uint32_t index = (wheel->base >> level_shift(level)) & LEVEL_MASK;
+    uint16_t slot = level_slot(level, index);
+    uint16_t e = wheel->heads[slot];
+    wheel->heads[slot] = TIMER_WHEEL_NONE;
+    while (e != TIMER_WHEEL_NONE) {
+        uint16_t next = wheel->nodes[e].next;
+        place(wheel, e);
+        e = next;
+    }
+    return index;
+}
+
+void timer_wheel_init(TimerWheel* wheel, uint32_t now)
+{
+    wheel->base = now + 1;
+    wheel->count = 0;
+    memset(wheel->heads, 0xff, sizeof(wheel->heads));
+    for (uint32_t i = 0; i < MAX_ENTITIES; i++) {
+        wheel->nodes[i].slot = TIMER_WHEEL_NONE;
+    }
+}
+
+void timer_wheel_schedule(TimerWheel* wheel, Entity e, uint32_t expire_tick)
+{
+    if (e >= MAX_ENTITIES) return;
+    timer_wheel_cancel(wheel, e);
+    wheel->nodes[e].expire_tick = expire_tick;
+    place(wheel, e);
+    wheel->count++;
+}
+
+void timer_wheel_cancel(TimerWheel* wheel, Entity e)
+{
+    if (!timer_wheel_is_scheduled(wheel, e)) return;
+    unlink(wheel, e);
+    wheel->count--;
+}
+
+bool timer_wheel_is_scheduled(const TimerWheel* wheel, Entity e)
+{
+    return e < MAX_ENTITIES && wheel->nodes[e].slot != TIMER_WHEEL_NONE;
+}
+
+uint32_t timer_wheel_advance(TimerWheel* wheel, uint32_t now, Entity* out_entities)
+{
+    uint32_t expired = 0;
+    while ((int32_t)(now - wheel->base) >= 0) {
+        uint32_t index = wheel->base & ROOT_MASK;
+        // Wrapping the root brings the next coarse slot down, which may wrap the level above it
+        for (int level = 1; index == 0 && level < TIMER_WHEEL_LEVELS; level++) {
+            if (cascade(wheel, level) != 0) break;
+        }
+
+        uint16_t e = wheel->heads[index];
+        wheel->heads[index] = TIMER_WHEEL_NONE;
+        while (e != TIMER_WHEEL_NONE) {
+            TimerNode* node = &wheel->nodes[e];
+            uint16_t next = node->next;
+            node->slot = TIMER_WHEEL_NONE;
+            if ((int32_t)(node->expire_tick - wheel->base) > 0) {
+                // Clamped past the wheel's range, go around again
+                place(wheel, e);
+            } else {
+                out_entities[expired++] = e;
+                wheel->count--;
+            }
+            e = next;
+        }
+        wheel->base++;
+        // Skip empty stretches once nothing is scheduled
+        if (wheel->count == 0 && (int32_t)(now - wheel->base) >= 0) {
+            wheel->base = now + 1;
+        }
+    }
+    return expired;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ecs.h"
+
+/*
+  Hierarchical timing wheel with at most one timer per entity, keyed by
+  absolute tick. Level 0 has one slot per tick, each higher level covers
+  the whole span of the level below per slot. Advancing past a level's
+  boundary cascades that level's next slot down, so scheduling,
+  cancelling and expiring are all O(1). Timers further out than the
+  wheel spans fire at the end of its range and are rescheduled by the
+  caller if needed.
+ */
+#define TIMER_WHEEL_LEVELS     4
+#define TIMER_WHEEL_ROOT_BITS  8
+#define TIMER_WHEEL_LEVEL_BITS 6
+#define TIMER_WHEEL_ROOT_SLOTS  (1u << TIMER_WHEEL_ROOT_BITS)
+#define TIMER_WHEEL_LEVEL_SLOTS (1u << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_MAX_DELAY   ((1u << (TIMER_WHEEL_ROOT_BITS + (TIMER_WHEEL_LEVELS - 1) * TIMER_WHEEL_LEVEL_BITS)) - 1)
+
+#define TIMER_WHEEL_NONE 0xFFFFu
+
+typedef struct {
+    uint16_t next;
+    uint16_t prev;
+    uint16_t slot;         // Flat slot index, TIMER_WHEEL_NONE when unscheduled
+    uint32_t expire_tick;
+} TimerNode;
+
+typedef struct {
+    uint32_t base;         // Next tick to process
+    uint32_t count;
+    uint16_t heads[TIMER_WHEEL_ROOT_SLOTS + (TIMER_WHEEL_LEVELS - 1) * TIMER_WHEEL_LEVEL_SLOTS];
+    TimerNode nodes[MAX_ENTITIES];
+} TimerWheel;
+
+// Ticks up to and including `now` count as processed
+void timer_wheel_init(TimerWheel* wheel, uint32_t now);
+
+// Replaces any timer e already has. Ticks already processed fire on the next advance.
+void timer_wheel_schedule(TimerWheel* wheel, Entity e, uint32_t expire_tick);
+void timer_wheel_cancel(TimerWheel* wheel, Entity e);
+bool timer_wheel_is_scheduled(const TimerWheel* wheel, Entity e);
+
+// Moves to tick `now` and writes every entity that expired on the way to out_entities,
+// which must hold MAX_ENTITIES. Returns how many were written.
+uint32_t timer_wheel_advance(TimerWheel* wheel, uint32_t now, Entity* out_entities);
@@ -1,4 +0,0 @@
-#include "transform.h"
-#include "ecs.h"
-
-ECS_COMPONENT_ACCESSORS(transform, TransformComponent, COMPONENT_TRANSFORM)
@@ -10,6 +10,4 @@ typedef struct {
     bool dirty;
 } TransformComponent;
 
-// Macro generated
-TransformComponent* entity_get_transform(Entity e);
-void entity_set_transform(Entity e, TransformComponent component);
+ECS_COMPONENT_DECLARE(transform, TransformComponent, COMPONENT_TRANSFORM)
@@ -0,0 +1,114 @@
+#include "worker.h"
+#include "profile.h"
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define WORKER_THREADS 0
+#else
+#define WORKER_THREADS 1
+#include <pthread.h>
+#endif
+
+#if WORKER_THREADS
+
+static pthread_t thread;
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t kicked = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t finished = PTHREAD_COND_INITIALIZER;
+static WorkerJob pending_job;
+static void* pending_arg;
+static bool busy;           // A job was kicked and has not finished
+static bool running;
+static bool stopping;
+static const char* thread_name;
+
+static void* worker_main(void* unused)
+{
+    (void)unused;
+    profile_set_thread_name(thread_name);
+
+    pthread_mutex_lock(&mutex);
+    for (;;) {
+        while (!pending_job && !stopping) {
+            pthread_cond_wait(&kicked, &mutex);
+        }
+        if (!pending_job) break;
+
+        WorkerJob job = pending_job;
+        void* arg = pending_arg;
+        pending_job = NULL;
+        pthread_mutex_unlock(&mutex);
+
+        job(arg);
+
+        pthread_mutex_lock(&mutex);
+        busy = false;
+        pthread_cond_signal(&finished);
+    }
+    pthread_mutex_unlock(&mutex);
+    return NULL;
+}
+
+bool worker_start(const char* name)
+{
+    if (running) return true;
+    thread_name = name;
+    stopping = false;
+    running = pthread_create(&thread, NULL, worker_main, NULL) == 0;
+    return running;
+}
+
+void worker_stop(void)
+{
+    if (!running) return;
+    worker_wait();
+    pthread_mutex_lock(&mutex);
+    stopping = true;
+    pthread_cond_signal(&kicked);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(thread, NULL);
+    running = false;
+}
+
+void worker_kick(WorkerJob job, void* arg)
+{
+    if (!running) {
+        job(arg);
+        return;
+    }
+    worker_wait();
+    pthread_mutex_lock(&mutex);
+    pending_job = job;
+    pending_arg = arg;
+    busy = true;
+    pthread_cond_signal(&kicked);
+    pthread_mutex_unlock(&mutex);
+}
+
+void worker_wait(void)
+{
+    if (!running) return;
+    pthread_mutex_lock(&mutex);
+    while (busy) {
+        pthread_cond_wait(&finished, &mutex);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+#else
+
+bool worker_start(const char* name)
+{
+    (void)name;
+    return false;
+}
+
+void worker_stop(void) {}
+
+void worker_kick(WorkerJob job, void* arg)
+{
+    job(arg);
+}
+
+void worker_wait(void) {}
+
+#endif
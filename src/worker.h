@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdbool.h>
+
+/*
+  One background thread that runs a job while the caller does other
+  work, e.g. the next simulation tick while the main thread submits the
+  previous frame to the GPU. worker_kick hands over a job and returns at
+  once, worker_wait blocks until it has finished. Between a wait and the
+  next kick the caller owns everything the job touches.
+
+  Builds without threads (emscripten without -pthread), or a worker that
+  was never started, run the job inside worker_kick instead.
+ */
+
+typedef void (*WorkerJob)(void* arg);
+
+// `name` labels the thread in profiler traces, false if no thread could be made
+bool worker_start(const char* name);
+// Waits for the running job, then joins the thread
+void worker_stop(void);
+
+void worker_kick(WorkerJob job, void* arg);
+void worker_wait(void);
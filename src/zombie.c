@@ -0,0 +1,79 @@
+#include "zombie.h"
+#include "transform.h"
+#include "physics.h"
+#include "flowfield.h"
+#include "profile.h"
+#include "lod.h"
+
+#include <math.h>
+
+static const float ZOMBIE_SPEED = 3.0f;
+static const float ZOMBIE_REACH = 1.5f;     // Stop pushing once this close to the target
+
+Entity zombie_spawn(const vec3 position, const RenderComponent* render)
+{
+    Entity e = entity_create();
+    if (e == INVALID_ENTITY) return e;
+
+    TransformComponent t = {
+        .position = {position[0], position[1], position[2]},
+        .rotation = {0.0f, 0.0f, 0.0f, 1.0f},
+        .scale = {0.8f, 0.8f, 0.8f}
+    };
+    entity_set_transform(e, t);
+    if (render) {
+        entity_set_render(e, *render);
+    }
+    entity_set_collision(e, (CollisionComponent){ .size = {1, 1, 1}, .center_offset = {0, 0, 0}, .is_static = false,
+                                                 .layer = PHYSICS_LAYER_ZOMBIE, .mask = PHYSICS_MASK_ZOMBIE });
+    entity_set_velocity(e, (VelocityComponent){ .velocity = {0, 0, 0} });
+    entity_set_health(e, (HealthComponent){ .current_health = 30.0f, .max_health = 30.0f });
+    entity_set_zombie(e, (ZombieComponent){ .speed = ZOMBIE_SPEED });
+    return e;
+}
+
+void zombie_system_update(Entity target, float delta_time)
+{
+    (void)delta_time;
+    TransformComponent* target_t = entity_get_transform(target);
+    if (!target_t) return;
+
+    PROFILE_BEGIN("zombie_system_update");
+    flowfield_update(target_t->position);
+
+    const uint32_t required = COMPONENT_ZOMBIE | COMPONENT_TRANSFORM | COMPONENT_VELOCITY;
+    for (Entity e = 0; e < MAX_ENTITIES; e++) {
+        if (!entity_is_alive(e)) continue;
+        if ((registry.component_masks[e] & required) != required) continue;
+        if (!lod_is_due(e)) continue; // Keeps its last velocity until its LOD slot comes up
+
+        ZombieComponent* z = entity_get_zombie_unchecked(e);
+        TransformComponent* t = entity_get_transform_unchecked(e);
+        VelocityComponent* v = entity_get_velocity_unchecked(e);
+
+        // Sleeping zombies cost nothing until the field changes
+        if (physics_is_sleeping(e)) {
+            if (z->field_version == flowfield_version()) continue;
+            physics_wake(e);
+        }
+
+        z->field_version = flowfield_version();
+
+        vec3 dir;
+        vec3 to_target;
+        vec3_sub(to_target, target_t->position, t->position);
+        to_target[1] = 0.0f;
+        float straight = vec3_len(to_target);
+
+        if (!flowfield_sample(t->position, dir) || (dir[0] == 0.0f && dir[2] == 0.0f)) {
+            // Goal cell (or cut off): head straight for the target
+            if (straight > ZOMBIE_REACH) {
+                vec3_scale(dir, to_target, 1.0f / straight);
+            } else {
+                dir[0] = dir[1] = dir[2] = 0.0f;
+            }
+        }
+        vec3_scale(v->velocity, dir, z->speed);
+    }
+    PROFILE_END("zombie_system_update");
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "ecs.h"
+#include "render.h"
+
+typedef struct {
+    float speed;          // Units per second along the flow field
+    uint32_t field_version;  // Flow field it last steered by, a sleeping zombie wakes when it changes
+} ZombieComponent;
+
+ECS_COMPONENT_DECLARE(zombie, ZombieComponent, COMPONENT_ZOMBIE)
+
+Entity zombie_spawn(const vec3 position, const RenderComponent* render);
+
+// Steers every zombie toward the target along the shared flow field
+void zombie_system_update(Entity target, float delta_time);